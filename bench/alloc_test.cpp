@@ -0,0 +1,262 @@
+/*
+    Copyright (C) 2024 Devin Davila
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+// Fails when a steady-state tick, render or capture call allocates.
+// The source runs against the stub graphics layer in gs_stub.cpp and is fed a sine through the stub output bus,
+// operator new and bmalloc()/brealloc() are replaced by counting versions that are armed after a warm-up.
+// usage: waveform_alloc_test [frames]
+
+#include "gs_stub.hpp"
+#include "source.hpp"
+#include "settings.hpp"
+#include "vbuf_pool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <dlfcn.h>
+#include <new>
+#include <numbers>
+#include <thread>
+
+namespace
+{
+    constexpr int WARMUP_FRAMES = 120;
+    constexpr int HEIGHT = 450;
+    constexpr uint32_t SAMPLE_RATE = 48000;
+
+    std::atomic<bool> s_counting{ false };
+    std::atomic<uint64_t> s_allocs{ 0 };
+
+    void count_alloc()
+    {
+        if(s_counting.load(std::memory_order_relaxed))
+            s_allocs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void *alloc(std::size_t size, std::size_t alignment)
+    {
+        count_alloc();
+        size = std::max(size, (std::size_t)1);
+        auto ptr = (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) ? std::aligned_alloc(alignment, ((size + alignment - 1) / alignment) * alignment) : std::malloc(size);
+        if(ptr == nullptr)
+            throw std::bad_alloc();
+        return ptr;
+    }
+
+    template<typename T>
+    T next_symbol(const char *name)
+    {
+        auto sym = reinterpret_cast<T>(dlsym(RTLD_NEXT, name));
+        if(sym == nullptr)
+        {
+            std::fprintf(stderr, "%s not found\n", name);
+            std::abort();
+        }
+        return sym;
+    }
+
+    struct Case
+    {
+        const char *name;
+        const char *mode;
+        void (*setup)(obs_data_t *settings);
+    };
+
+    const Case CASES[] = {
+        { "curve", P_CURVE, [](obs_data_t *) {} },
+        { "curve, ltas", P_CURVE, [](obs_data_t *s) { obs_data_set_bool(s, P_LTAS, true); } },
+        { "curve, half history", P_CURVE, [](obs_data_t *s) { obs_data_set_bool(s, P_HALF_HISTORY, true); } },
+        { "bars, gauss filter", P_BARS, [](obs_data_t *s) { obs_data_set_string(s, P_FILTER_MODE, P_GAUSS); } },
+        { "bars, filter bank", P_BARS, [](obs_data_t *s) { obs_data_set_bool(s, P_FILTERBANK, true); } },
+        { "stepped bars", P_STEP_BARS, [](obs_data_t *) {} },
+        { "level meter", P_LEVEL_METER, [](obs_data_t *) {} },
+        { "level meter, ppm", P_LEVEL_METER, [](obs_data_t *s) { obs_data_set_string(s, P_METER_BALLISTICS, P_PPM_I); } },
+        { "stepped level meter", P_STEPPED_METER, [](obs_data_t *) {} },
+        { "waveform", P_WAVEFORM, [](obs_data_t *) {} },
+        { "oscilloscope", P_WAVEFORM, [](obs_data_t *s) { obs_data_set_bool(s, P_SCOPE, true); } },
+        { "vectorscope", P_VECTORSCOPE, [](obs_data_t *) {} },
+        { "curve, normalized volume", P_CURVE, [](obs_data_t *s) { obs_data_set_bool(s, P_NORMALIZE_VOLUME, true); } },
+    };
+
+    // a 1 kHz sine slightly out of phase between channels, delivered as real time passes
+    class AudioFeed
+    {
+    public:
+        AudioFeed() : m_start(os_gettime_ns()) {}
+
+        void pump()
+        {
+            const auto now = os_gettime_ns();
+            const uint64_t due = ((now - m_start) * SAMPLE_RATE) / 1000000000u;
+            while(m_sent < due)
+            {
+                const auto frames = (uint32_t)std::min(due - m_sent, (uint64_t)AUDIO_OUTPUT_FRAMES);
+                for(auto i = 0u; i < frames; ++i)
+                {
+                    const auto t = (float)(m_sent + i) / (float)SAMPLE_RATE;
+                    m_planes[0][i] = 0.5f * std::sin(2.0f * std::numbers::pi_v<float> * 1000.0f * t);
+                    m_planes[1][i] = 0.5f * std::sin((2.0f * std::numbers::pi_v<float> * 1000.0f * t) + 0.3f);
+                }
+
+                audio_data packet{};
+                packet.data[0] = (uint8_t*)m_planes[0];
+                packet.data[1] = (uint8_t*)m_planes[1];
+                packet.frames = frames;
+                packet.timestamp = m_start + audio_frames_to_ns(SAMPLE_RATE, m_sent);
+                gs_stub::output_audio(&packet);
+                m_sent += frames;
+            }
+        }
+
+    private:
+        uint64_t m_start;
+        uint64_t m_sent = 0;
+        float m_planes[2][AUDIO_OUTPUT_FRAMES]{};
+    };
+
+    // allocations over the measured frames
+    template<typename Source>
+    uint64_t run_source(obs_data_t *settings, int frames)
+    {
+        Source source(nullptr);
+        source.update(settings);
+        source.show(); // update() asks libobs, which has no source to show
+        gs_stub::set_viewport((int)source.width(), (int)source.height());
+
+        AudioFeed feed;
+        auto last = std::chrono::steady_clock::now();
+        for(auto i = 0; i < WARMUP_FRAMES + frames; ++i)
+        {
+            if(i == WARMUP_FRAMES)
+            {
+                s_allocs = 0;
+                s_counting = true;
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            feed.pump();
+            const auto now = std::chrono::steady_clock::now();
+            source.tick(std::chrono::duration<float>(now - last).count());
+            last = now;
+            source.render(nullptr);
+        }
+        s_counting = false;
+        return s_allocs;
+    }
+
+    // same selection as the source's create callback
+    uint64_t run(obs_data_t *settings, int frames)
+    {
+#ifdef ENABLE_X86_SIMD
+        if(WAVSource::HAVE_AVX2)
+            return run_source<WAVSourceAVX2>(settings, frames);
+        if(WAVSource::HAVE_AVX)
+            return run_source<WAVSourceAVX>(settings, frames);
+#endif // ENABLE_X86_SIMD
+        return run_source<WAVSourceGeneric>(settings, frames);
+    }
+}
+
+// counting replacements, the array and nothrow forms forward to these
+void *operator new(std::size_t size)
+{
+    return alloc(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment)
+{
+    return alloc(size, (std::size_t)alignment);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, [[maybe_unused]] std::align_val_t alignment) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, [[maybe_unused]] std::size_t size) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, [[maybe_unused]] std::size_t size, [[maybe_unused]] std::align_val_t alignment) noexcept
+{
+    std::free(ptr);
+}
+
+// libobs keeps its own allocator, the calls are only counted on the way through
+extern "C"
+{
+    void *bmalloc(size_t size)
+    {
+        static const auto next = next_symbol<void*(*)(size_t)>("bmalloc");
+        count_alloc();
+        return next(size);
+    }
+
+    void *brealloc(void *ptr, size_t size)
+    {
+        static const auto next = next_symbol<void*(*)(void*, size_t)>("brealloc");
+        count_alloc();
+        return next(ptr, size);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const auto frames = (argc > 1) ? std::max(std::atoi(argv[1]), 1) : 600;
+
+    WAVSource::register_source();
+    const auto info = gs_stub::source_info();
+    if(info == nullptr)
+    {
+        std::fprintf(stderr, "source was not registered\n");
+        return 1;
+    }
+
+    auto failed = 0;
+    for(const auto& test : CASES)
+    {
+        auto settings = obs_data_create();
+        info->get_defaults(settings);
+        obs_data_set_string(settings, P_AUDIO_SRC, P_OUTPUT_BUS);
+        obs_data_set_string(settings, P_DISPLAY_MODE, test.mode);
+        obs_data_set_string(settings, P_CHANNEL_MODE, P_STEREO);
+        obs_data_set_int(settings, P_HEIGHT, HEIGHT);
+        test.setup(settings);
+
+        const auto allocs = run(settings, frames);
+        obs_data_release(settings);
+
+        std::printf("%-28s %s (%llu allocations in %d frames)\n", test.name, (allocs == 0) ? "ok" : "FAILED", (unsigned long long)allocs, frames);
+        if(allocs != 0)
+            ++failed;
+    }
+
+    obs_enter_graphics();
+    vbuf_pool::clear();
+    obs_leave_graphics();
+    return (failed == 0) ? 0 : 1;
+}
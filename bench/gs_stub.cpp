@@ -0,0 +1,354 @@
+/*
+    Copyright (C) 2024 Devin Davila
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "gs_stub.hpp"
+#include <vector>
+
+namespace
+{
+    struct VertexBuffer
+    {
+        gs_vb_data *data;
+    };
+
+    struct Texture
+    {
+        uint32_t width;
+        uint32_t height;
+        uint32_t linesize;
+        std::vector<uint8_t> pixels;
+    };
+
+    GSStats s_stats;
+    bool s_hash = false;
+    gs_rect s_viewport{ 0, 0, 0, 0 };
+    obs_source_info s_source_info{};
+    bool s_registered = false;
+    VertexBuffer *s_loaded = nullptr;
+    audio_output_callback_t s_audio_callback = nullptr;
+    void *s_audio_param = nullptr;
+
+    // effects, techniques and parameters are never looked into, any non-null pointer will do
+    char s_handle;
+
+    template<typename T>
+    T *handle()
+    {
+        return reinterpret_cast<T*>(&s_handle);
+    }
+
+    constexpr uint64_t FNV_BASIS = 0xcbf29ce484222325ull;
+    constexpr uint64_t FNV_PRIME = 0x100000001b3ull;
+
+    void hash(const void *data, size_t size)
+    {
+        if(s_stats.checksum == 0)
+            s_stats.checksum = FNV_BASIS;
+        auto bytes = static_cast<const uint8_t*>(data);
+        for(size_t i = 0; i < size; ++i)
+            s_stats.checksum = (s_stats.checksum ^ bytes[i]) * FNV_PRIME;
+    }
+
+    // the vertex attributes the source fills in, vec3 padding is left out
+    void hash_vertices(const gs_vb_data *data)
+    {
+        if(!s_hash)
+            return;
+        for(size_t i = 0; i < data->num; ++i)
+            hash(data->points[i].ptr, 3 * sizeof(float));
+        for(size_t i = 0; i < data->num_tex; ++i)
+            hash(data->tvarray[i].array, data->num * data->tvarray[i].width * sizeof(float));
+    }
+
+    size_t vertex_size(const gs_vb_data *data)
+    {
+        auto size = sizeof(vec3);
+        if(data->normals != nullptr)
+            size += sizeof(vec3);
+        if(data->tangents != nullptr)
+            size += sizeof(vec3);
+        if(data->colors != nullptr)
+            size += sizeof(uint32_t);
+        for(size_t i = 0; i < data->num_tex; ++i)
+            size += data->tvarray[i].width * sizeof(float);
+        return size;
+    }
+}
+
+namespace gs_stub
+{
+    GSStats& stats()
+    {
+        return s_stats;
+    }
+
+    void reset_stats()
+    {
+        s_stats = {};
+    }
+
+    void hash_uploads(bool enable)
+    {
+        s_hash = enable;
+    }
+
+    void set_viewport(int width, int height)
+    {
+        s_viewport = { 0, 0, width, height };
+    }
+
+    const obs_source_info *source_info()
+    {
+        return s_registered ? &s_source_info : nullptr;
+    }
+
+    void output_audio(audio_data *audio)
+    {
+        if(s_audio_callback != nullptr)
+            s_audio_callback(s_audio_param, 0, audio);
+    }
+}
+
+extern "C"
+{
+    bool obs_get_audio_info(obs_audio_info *oai)
+    {
+        *oai = {};
+        oai->samples_per_sec = 48000;
+        oai->speakers = SPEAKERS_STEREO;
+        return true;
+    }
+
+    bool obs_get_video_info(obs_video_info *ovi)
+    {
+        // a canvas larger than any source so the viewport alone decides the scale
+        *ovi = {};
+        ovi->fps_num = 60;
+        ovi->fps_den = 1;
+        ovi->base_width = 7680;
+        ovi->base_height = 4320;
+        return true;
+    }
+
+    // libobs core calls dereference the global core object, which only obs_startup() creates,
+    // answer them here as a core without graphics, audio output or other sources would
+    void obs_enter_graphics() {}
+    void obs_leave_graphics() {}
+
+    audio_t *obs_get_audio()
+    {
+        return nullptr;
+    }
+
+    // the output bus is 48 kHz stereo like obs_get_audio_info(), only one connection is kept
+    const audio_output_info *audio_output_get_info([[maybe_unused]] const audio_t *audio)
+    {
+        static const audio_output_info info{ "stub", 48000, AUDIO_FORMAT_FLOAT_PLANAR, SPEAKERS_STEREO };
+        return &info;
+    }
+
+    bool audio_output_connect([[maybe_unused]] audio_t *audio, [[maybe_unused]] size_t mix_idx, [[maybe_unused]] const audio_convert_info *conversion, audio_output_callback_t callback, void *param)
+    {
+        s_audio_callback = callback;
+        s_audio_param = param;
+        return true;
+    }
+
+    void audio_output_disconnect([[maybe_unused]] audio_t *audio, [[maybe_unused]] size_t mix_idx, audio_output_callback_t callback, void *param)
+    {
+        if((s_audio_callback == callback) && (s_audio_param == param))
+        {
+            s_audio_callback = nullptr;
+            s_audio_param = nullptr;
+        }
+    }
+
+    void obs_queue_task([[maybe_unused]] obs_task_type type, obs_task_t task, void *param, [[maybe_unused]] bool wait)
+    {
+        task(param);
+    }
+
+    obs_source_t *obs_get_source_by_name([[maybe_unused]] const char *name)
+    {
+        return nullptr;
+    }
+
+    char *obs_find_module_file([[maybe_unused]] obs_module_t *module, [[maybe_unused]] const char *file)
+    {
+        return nullptr;
+    }
+
+    // no config directory, calibration runs without its cache
+    char *obs_module_get_config_path([[maybe_unused]] obs_module_t *module, [[maybe_unused]] const char *file)
+    {
+        return nullptr;
+    }
+
+    void obs_register_source_s(const obs_source_info *info, size_t size)
+    {
+        if(size != sizeof(obs_source_info))
+            return;
+        s_source_info = *info;
+        s_registered = true;
+    }
+
+    gs_effect_t *gs_effect_create_from_file([[maybe_unused]] const char *file, char **error_string)
+    {
+        if(error_string != nullptr)
+            *error_string = nullptr;
+        return handle<gs_effect_t>();
+    }
+
+    void gs_effect_destroy([[maybe_unused]] gs_effect_t *effect) {}
+
+    gs_technique_t *gs_effect_get_technique([[maybe_unused]] const gs_effect_t *effect, [[maybe_unused]] const char *name)
+    {
+        return handle<gs_technique_t>();
+    }
+
+    gs_eparam_t *gs_effect_get_param_by_name([[maybe_unused]] const gs_effect_t *effect, [[maybe_unused]] const char *name)
+    {
+        return handle<gs_eparam_t>();
+    }
+
+    void gs_effect_set_bool([[maybe_unused]] gs_eparam_t *param, [[maybe_unused]] bool val) {}
+    void gs_effect_set_float([[maybe_unused]] gs_eparam_t *param, [[maybe_unused]] float val) {}
+    void gs_effect_set_vec2([[maybe_unused]] gs_eparam_t *param, [[maybe_unused]] const vec2 *val) {}
+    void gs_effect_set_vec4([[maybe_unused]] gs_eparam_t *param, [[maybe_unused]] const vec4 *val) {}
+    void gs_effect_set_texture([[maybe_unused]] gs_eparam_t *param, [[maybe_unused]] gs_texture_t *val) {}
+
+    size_t gs_technique_begin([[maybe_unused]] gs_technique_t *technique)
+    {
+        return 1;
+    }
+
+    void gs_technique_end([[maybe_unused]] gs_technique_t *technique) {}
+
+    bool gs_technique_begin_pass([[maybe_unused]] gs_technique_t *technique, [[maybe_unused]] size_t pass)
+    {
+        return true;
+    }
+
+    void gs_technique_end_pass([[maybe_unused]] gs_technique_t *technique) {}
+
+    gs_vertbuffer_t *gs_vertexbuffer_create(gs_vb_data *data, [[maybe_unused]] uint32_t flags)
+    {
+        if(data == nullptr)
+            return nullptr;
+        return reinterpret_cast<gs_vertbuffer_t*>(new VertexBuffer{ data });
+    }
+
+    void gs_vertexbuffer_destroy(gs_vertbuffer_t *vertbuffer)
+    {
+        auto vb = reinterpret_cast<VertexBuffer*>(vertbuffer);
+        if(vb == nullptr)
+            return;
+        if(s_loaded == vb)
+            s_loaded = nullptr;
+        gs_vbdata_destroy(vb->data);
+        delete vb;
+    }
+
+    void gs_vertexbuffer_flush(gs_vertbuffer_t *vertbuffer)
+    {
+        auto vb = reinterpret_cast<VertexBuffer*>(vertbuffer);
+        if(vb != nullptr)
+        {
+            s_stats.vbuf_bytes += vb->data->num * vertex_size(vb->data);
+            hash_vertices(vb->data);
+        }
+    }
+
+    gs_vb_data *gs_vertexbuffer_get_data(const gs_vertbuffer_t *vertbuffer)
+    {
+        auto vb = reinterpret_cast<const VertexBuffer*>(vertbuffer);
+        return (vb != nullptr) ? vb->data : nullptr;
+    }
+
+    void gs_load_vertexbuffer(gs_vertbuffer_t *vertbuffer)
+    {
+        s_loaded = reinterpret_cast<VertexBuffer*>(vertbuffer);
+    }
+
+    void gs_load_indexbuffer([[maybe_unused]] gs_indexbuffer_t *indexbuffer) {}
+
+    void gs_draw([[maybe_unused]] gs_draw_mode draw_mode, [[maybe_unused]] uint32_t start_vert, uint32_t num_verts)
+    {
+        ++s_stats.draws;
+        if((num_verts == 0) && (s_loaded != nullptr))
+            num_verts = (uint32_t)s_loaded->data->num;
+        s_stats.vertices += num_verts;
+    }
+
+    gs_texture_t *gs_texture_create(uint32_t width, uint32_t height, gs_color_format color_format, [[maybe_unused]] uint32_t levels, [[maybe_unused]] const uint8_t **data, [[maybe_unused]] uint32_t flags)
+    {
+        const auto linesize = width * (gs_get_format_bpp(color_format) / 8);
+        return reinterpret_cast<gs_texture_t*>(new Texture{ width, height, linesize, std::vector<uint8_t>((size_t)linesize * height) });
+    }
+
+    void gs_texture_destroy(gs_texture_t *tex)
+    {
+        delete reinterpret_cast<Texture*>(tex);
+    }
+
+    uint32_t gs_texture_get_width(const gs_texture_t *tex)
+    {
+        return reinterpret_cast<const Texture*>(tex)->width;
+    }
+
+    uint32_t gs_texture_get_height(const gs_texture_t *tex)
+    {
+        return reinterpret_cast<const Texture*>(tex)->height;
+    }
+
+    bool gs_texture_map(gs_texture_t *tex, uint8_t **ptr, uint32_t *linesize)
+    {
+        auto texture = reinterpret_cast<Texture*>(tex);
+        *ptr = texture->pixels.data();
+        *linesize = texture->linesize;
+        return true;
+    }
+
+    void gs_texture_unmap(gs_texture_t *tex)
+    {
+        // the whole texture goes up on unmap
+        auto texture = reinterpret_cast<Texture*>(tex);
+        s_stats.tex_bytes += texture->pixels.size();
+        if(s_hash)
+            hash(texture->pixels.data(), texture->pixels.size());
+    }
+
+    gs_texture_t *gs_get_render_target()
+    {
+        return nullptr;
+    }
+
+    void gs_get_viewport(gs_rect *rect)
+    {
+        *rect = s_viewport;
+    }
+
+    void gs_matrix_get(matrix4 *dst)
+    {
+        *dst = {};
+        dst->x.x = 1.0f;
+        dst->y.y = 1.0f;
+        dst->z.z = 1.0f;
+        dst->t.w = 1.0f;
+    }
+}
@@ -0,0 +1,54 @@
+/*
+    Copyright (C) 2024 Devin Davila
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+#include <obs-module.h>
+#include <cstdint>
+
+// Stand-in for the libobs graphics subsystem, linked into the render benchmark ahead of libobs.
+// Nothing is drawn, vertex buffers and textures are plain memory and every upload is counted.
+// Also answers obs_get_audio_info()/obs_get_video_info(), the core calls reached from update() and render()
+// and captures the registered source info, so the benchmark runs without obs_startup().
+// Tasks queued with obs_queue_task() run inline, as they do when queued from the thread they're meant for.
+// The output bus is a single stub connection, its audio is whatever the caller feeds to output_audio().
+struct GSStats
+{
+    uint64_t draws = 0;
+    uint64_t vertices = 0;      // drawn
+    uint64_t vbuf_bytes = 0;    // vertex data flushed
+    uint64_t tex_bytes = 0;     // texture data written through gs_texture_map()
+    uint64_t checksum = 0;      // FNV-1a of the vertex data flushed and the textures written, in order (see hash_uploads())
+};
+
+namespace gs_stub
+{
+    GSStats& stats();
+    void reset_stats();
+
+    // off by default, the benchmark doesn't pay for hashing
+    void hash_uploads(bool enable);
+
+    // the swap chain size, curve LODs are picked from it
+    void set_viewport(int width, int height);
+
+    // the info passed to obs_register_source(), null before
+    const obs_source_info *source_info();
+
+    // hand a packet to the callback connected to the output bus, if any
+    void output_audio(audio_data *audio);
+}
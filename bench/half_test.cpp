@@ -0,0 +1,82 @@
+/*
+    Copyright (C) 2024 Devin Davila
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+// Checks the scalar binary16 conversion in half.hpp bit for bit against F16C, over every half and every float.
+// The generic path and the AVX paths share the half history buffers, so they have to agree exactly.
+// Built with F16C enabled, needs a CPU that has it.
+// usage: waveform_half_test
+
+#include "half.hpp"
+#include <immintrin.h>
+#include <cstdio>
+
+namespace
+{
+    constexpr int MAX_REPORTS = 8;
+
+    int check_half_to_float()
+    {
+        auto failed = 0;
+        for(uint32_t h = 0; h < 0x10000u; ++h)
+        {
+            const auto expected = std::bit_cast<uint32_t>(_cvtsh_ss((unsigned short)h));
+            const auto actual = std::bit_cast<uint32_t>(half_to_float((uint16_t)h));
+            if(actual != expected)
+            {
+                if(failed < MAX_REPORTS)
+                    std::printf("half_to_float(0x%04x) = 0x%08x, F16C gives 0x%08x\n", h, actual, expected);
+                ++failed;
+            }
+        }
+        return failed;
+    }
+
+    int check_float_to_half()
+    {
+        // 8 floats per conversion, all 2^32 bit patterns
+        alignas(32) uint32_t bits[8];
+        alignas(16) uint16_t expected[8];
+        auto failed = 0;
+        for(uint64_t x = 0; x < 0x100000000ull; x += 8)
+        {
+            for(auto i = 0u; i < 8; ++i)
+                bits[i] = (uint32_t)x + i;
+            _mm_store_si128((__m128i*)expected, _mm256_cvtps_ph(_mm256_castsi256_ps(_mm256_load_si256((const __m256i*)bits)), _MM_FROUND_TO_NEAREST_INT));
+            for(auto i = 0u; i < 8; ++i)
+            {
+                const auto actual = float_to_half(std::bit_cast<float>(bits[i]));
+                if(actual != expected[i])
+                {
+                    if(failed < MAX_REPORTS)
+                        std::printf("float_to_half(0x%08x) = 0x%04x, F16C gives 0x%04x\n", bits[i], actual, expected[i]);
+                    ++failed;
+                }
+            }
+        }
+        return failed;
+    }
+}
+
+int main()
+{
+    const auto h2f = check_half_to_float();
+    std::printf("half_to_float %s (%d mismatches)\n", (h2f == 0) ? "ok" : "FAILED", h2f);
+    const auto f2h = check_float_to_half();
+    std::printf("float_to_half %s (%d mismatches)\n", (f2h == 0) ? "ok" : "FAILED", f2h);
+    return ((h2f == 0) && (f2h == 0)) ? 0 : 1;
+}
@@ -0,0 +1,213 @@
+/*
+    Copyright (C) 2024 Devin Davila
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+// Times render_curve()/render_bars() without a GPU or OBS.
+// The source runs against the stub graphics layer in gs_stub.cpp, its analysis output is synthesized
+// each frame instead of captured so only the render path is measured.
+// usage: waveform_render_bench [frames]
+
+#include "gs_stub.hpp"
+#include "source.hpp"
+#include "settings.hpp"
+#include "vbuf_pool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+    constexpr int WARMUP_FRAMES = 60;
+    constexpr int HEIGHT = 450;
+
+    struct Config
+    {
+        const char *mode;
+        const char *render;
+        int width;              // 0 for meters, their width follows from the bars
+        int bar_width;
+        int bar_gap;
+        int step_width;
+        int step_gap;
+        bool caps;
+    };
+
+    struct Result
+    {
+        double ns;          // per frame, all below too
+        double draws;
+        double vertices;
+        double bytes;
+    };
+
+    template<typename Base>
+    class BenchSource final : public Base
+    {
+    public:
+        BenchSource() : Base(nullptr) {}
+
+        // a falling spectrum with moving ripples over the whole floor to ceiling range,
+        // stepped bars emit a quad per lit step so the data decides their vertex count
+        void synthesize(int frame)
+        {
+            const auto range = this->m_ceiling - this->m_floor;
+            const auto t = (float)frame / 60.0f;
+            for(auto channel = 0u; channel < 2u; ++channel)
+            {
+                this->m_meter_val[channel] = this->m_floor + (range * (0.5f + (0.5f * std::sin(t * (2.0f + (float)channel)))));
+                if(this->m_meter_mode || (channel && !this->m_stereo))
+                    continue;
+                auto data = this->m_decibels[channel].get();
+                const auto bins = (float)(this->m_fft_size / 2);
+                for(size_t i = 0; i < this->m_bin_count; ++i)
+                {
+                    const auto x = (float)(i + this->m_bin_start) / bins;
+                    const auto ripple = 0.5f + (0.5f * std::sin((x * 40.0f) + (t * (3.0f + (float)channel))));
+                    data[i] = this->m_floor + (range * (1.0f - x) * ripple);
+                }
+            }
+        }
+    };
+
+    template<typename Base>
+    Result run_source(obs_data_t *settings, int frames)
+    {
+        BenchSource<Base> source;
+        source.update(settings);
+        gs_stub::set_viewport((int)source.width(), (int)source.height());
+
+        std::chrono::steady_clock::duration elapsed{};
+        for(auto i = 0; i < WARMUP_FRAMES + frames; ++i)
+        {
+            if(i == WARMUP_FRAMES)
+            {
+                gs_stub::reset_stats();
+                elapsed = {};
+            }
+            source.synthesize(i);
+            const auto start = std::chrono::steady_clock::now();
+            source.render(nullptr);
+            elapsed += std::chrono::steady_clock::now() - start;
+        }
+
+        const auto& stats = gs_stub::stats();
+        const auto n = (double)frames;
+        return {
+            (double)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / n,
+            (double)stats.draws / n,
+            (double)stats.vertices / n,
+            (double)(stats.vbuf_bytes + stats.tex_bytes) / n
+        };
+    }
+
+    // same selection as the source's create callback
+    Result run(obs_data_t *settings, int frames)
+    {
+#ifdef ENABLE_X86_SIMD
+        if(WAVSource::HAVE_AVX2)
+            return run_source<WAVSourceAVX2>(settings, frames);
+        if(WAVSource::HAVE_AVX)
+            return run_source<WAVSourceAVX>(settings, frames);
+#endif // ENABLE_X86_SIMD
+        return run_source<WAVSourceGeneric>(settings, frames);
+    }
+
+    std::vector<Config> make_sweep()
+    {
+        constexpr int widths[] = { 400, 800, 1920, 3840 };
+        constexpr int bars[][2] = { { 2, 1 }, { 8, 2 }, { 24, 6 } };
+        constexpr int steps[][2] = { { 2, 1 }, { 8, 2 } };
+
+        std::vector<Config> sweep;
+        for(auto render : { P_LINE, P_SOLID })
+            for(auto width : widths)
+                sweep.push_back({ P_CURVE, render, width, 0, 0, 0, 0, false });
+        for(auto width : widths)
+            for(auto& bar : bars)
+                for(auto caps : { false, true })
+                    sweep.push_back({ P_BARS, P_SOLID, width, bar[0], bar[1], 0, 0, caps });
+        for(auto width : widths)
+            for(auto& bar : bars)
+                for(auto& step : steps)
+                    sweep.push_back({ P_STEP_BARS, P_SOLID, width, bar[0], bar[1], step[0], step[1], false });
+        for(auto& bar : bars)
+            for(auto caps : { false, true })
+                sweep.push_back({ P_LEVEL_METER, P_SOLID, 0, bar[0], bar[1], 0, 0, caps });
+        for(auto& bar : bars)
+            for(auto& step : steps)
+                sweep.push_back({ P_STEPPED_METER, P_SOLID, 0, bar[0], bar[1], step[0], step[1], false });
+        return sweep;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const auto frames = (argc > 1) ? std::max(std::atoi(argv[1]), 1) : 1000;
+
+    WAVSource::register_source();
+    const auto info = gs_stub::source_info();
+    if(info == nullptr)
+    {
+        std::fprintf(stderr, "source was not registered\n");
+        return 1;
+    }
+
+    std::printf("%-20s %-6s %6s %7s %7s %5s %9s %6s %12s %10s\n", "mode", "render", "width", "bar", "step", "caps", "verts", "draws", "bytes/frame", "ns/frame");
+    for(const auto& cfg : make_sweep())
+    {
+        auto settings = obs_data_create();
+        info->get_defaults(settings);
+        obs_data_set_string(settings, P_DISPLAY_MODE, cfg.mode);
+        obs_data_set_string(settings, P_RENDER_MODE, cfg.render);
+        obs_data_set_string(settings, P_CHANNEL_MODE, P_STEREO);
+        obs_data_set_int(settings, P_HEIGHT, HEIGHT);
+        if(cfg.width > 0)
+            obs_data_set_int(settings, P_WIDTH, cfg.width);
+        if(cfg.bar_width > 0)
+        {
+            obs_data_set_int(settings, P_BAR_WIDTH, cfg.bar_width);
+            obs_data_set_int(settings, P_BAR_GAP, cfg.bar_gap);
+        }
+        if(cfg.step_width > 0)
+        {
+            obs_data_set_int(settings, P_STEP_WIDTH, cfg.step_width);
+            obs_data_set_int(settings, P_STEP_GAP, cfg.step_gap);
+        }
+        obs_data_set_bool(settings, P_CAPS, cfg.caps);
+
+        const auto res = run(settings, frames);
+        obs_data_release(settings);
+
+        char width[16] = "-", bar[16] = "-", step[16] = "-";
+        if(cfg.width > 0)
+            std::snprintf(width, sizeof(width), "%d", cfg.width);
+        if(cfg.bar_width > 0)
+            std::snprintf(bar, sizeof(bar), "%d+%d", cfg.bar_width, cfg.bar_gap);
+        if(cfg.step_width > 0)
+            std::snprintf(step, sizeof(step), "%d+%d", cfg.step_width, cfg.step_gap);
+        std::printf("%-20s %-6s %6s %7s %7s %5s %9.0f %6.1f %12.0f %10.0f\n", cfg.mode, cfg.render, width, bar, step, cfg.caps ? "on" : "off",
+            res.vertices, res.draws, res.bytes, res.ns);
+    }
+
+    obs_enter_graphics();
+    vbuf_pool::clear();
+    obs_leave_graphics();
+    return 0;
+}
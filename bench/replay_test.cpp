@@ -0,0 +1,247 @@
+/*
+    Copyright (C) 2024 Devin Davila
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+// Records a capture log from a live source, replays it into a new one and fails unless both end up rendering the same frame,
+// or if a log of another speaker layout is replayed at all.
+// Both run against the stub graphics layer in gs_stub.cpp, the live one is fed through the stub output bus in packets
+// of varying size, frames are compared by the checksum of everything the render uploads.
+// Given a log, replays it headlessly instead and prints the checksum of the last frame.
+// usage: waveform_replay_test [frames]
+//        waveform_replay_test <log> [display mode]
+
+#include "gs_stub.hpp"
+#include "capture_log.hpp"
+#include "source.hpp"
+#include "settings.hpp"
+#include "vbuf_pool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <numbers>
+#include <string>
+#include <thread>
+
+namespace
+{
+    constexpr int HEIGHT = 450;
+    constexpr uint32_t SAMPLE_RATE = 48000;
+    constexpr float FRAME_SECONDS = 1.0f / 60.0f;
+
+    struct Case
+    {
+        const char *name;
+        const char *mode;
+        void (*setup)(obs_data_t *settings);
+    };
+
+    const Case CASES[] = {
+        { "curve", P_CURVE, [](obs_data_t *) {} },
+        { "curve, normalized volume", P_CURVE, [](obs_data_t *s) { obs_data_set_bool(s, P_NORMALIZE_VOLUME, true); } },
+        { "bars", P_BARS, [](obs_data_t *) {} },
+        { "level meter", P_LEVEL_METER, [](obs_data_t *) {} },
+        { "waveform", P_WAVEFORM, [](obs_data_t *) {} },
+        { "vectorscope", P_VECTORSCOPE, [](obs_data_t *) {} },
+    };
+
+    // a sweep from 100 Hz up, delivered as real time passes in packets of 1 to AUDIO_OUTPUT_FRAMES frames
+    class PacketFeed
+    {
+    public:
+        PacketFeed() : m_start(os_gettime_ns()) {}
+
+        void pump()
+        {
+            const auto now = os_gettime_ns();
+            const uint64_t due = ((now - m_start) * SAMPLE_RATE) / 1000000000u;
+            while(m_sent < due)
+            {
+                m_seed = (m_seed * 1664525u) + 1013904223u;
+                const auto frames = (uint32_t)std::min(due - m_sent, (uint64_t)((m_seed >> 16) % AUDIO_OUTPUT_FRAMES) + 1);
+                for(auto i = 0u; i < frames; ++i)
+                {
+                    const auto t = (float)(m_sent + i) / (float)SAMPLE_RATE;
+                    const auto phase = 2.0f * std::numbers::pi_v<float> * ((100.0f * t) + (400.0f * t * t));
+                    m_planes[0][i] = 0.5f * std::sin(phase);
+                    m_planes[1][i] = 0.25f * std::sin(phase + 0.3f);
+                }
+
+                audio_data packet{};
+                packet.data[0] = (uint8_t*)m_planes[0];
+                packet.data[1] = (uint8_t*)m_planes[1];
+                packet.frames = frames;
+                packet.timestamp = m_start + audio_frames_to_ns(SAMPLE_RATE, m_sent);
+                gs_stub::output_audio(&packet);
+                m_sent += frames;
+            }
+        }
+
+    private:
+        uint64_t m_start;
+        uint64_t m_sent = 0;
+        uint32_t m_seed = 1;
+        float m_planes[2][AUDIO_OUTPUT_FRAMES]{};
+    };
+
+    // checksum of one more render, 0 if it uploaded nothing
+    uint64_t last_frame(WAVSource& source)
+    {
+        gs_stub::reset_stats();
+        source.render(nullptr);
+        return gs_stub::stats().checksum;
+    }
+
+    template<typename Source>
+    uint64_t record(obs_data_t *settings, const char *path, int frames)
+    {
+        Source source(nullptr);
+        source.update(settings);
+        source.show(); // update() asks libobs, which has no source to show
+        gs_stub::set_viewport((int)source.width(), (int)source.height());
+        source.start_capture_log(path);
+
+        PacketFeed feed;
+        auto last = std::chrono::steady_clock::now();
+        for(auto i = 0; i < frames; ++i)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            feed.pump();
+            const auto now = std::chrono::steady_clock::now();
+            source.tick(std::chrono::duration<float>(now - last).count());
+            last = now;
+            source.render(nullptr);
+        }
+        source.stop_capture_log();
+        return last_frame(source);
+    }
+
+    // as fast as possible, the replay itself limits the records handled per tick
+    template<typename Source>
+    uint64_t replay(obs_data_t *settings, const char *path)
+    {
+        Source source(nullptr);
+        source.update(settings);
+        source.show();
+        gs_stub::set_viewport((int)source.width(), (int)source.height());
+        source.replay_capture_log(path, 0.0);
+        if(!source.replaying())
+            return 0;
+
+        while(source.replaying())
+        {
+            source.tick(FRAME_SECONDS);
+            source.render(nullptr);
+        }
+        return last_frame(source);
+    }
+
+    // same selection as the source's create callback, 'frames' of live capture or a replay when 0
+    uint64_t run(obs_data_t *settings, const char *path, int frames)
+    {
+#ifdef ENABLE_X86_SIMD
+        if(WAVSource::HAVE_AVX2)
+            return (frames > 0) ? record<WAVSourceAVX2>(settings, path, frames) : replay<WAVSourceAVX2>(settings, path);
+        if(WAVSource::HAVE_AVX)
+            return (frames > 0) ? record<WAVSourceAVX>(settings, path, frames) : replay<WAVSourceAVX>(settings, path);
+#endif // ENABLE_X86_SIMD
+        return (frames > 0) ? record<WAVSourceGeneric>(settings, path, frames) : replay<WAVSourceGeneric>(settings, path);
+    }
+
+    obs_data_t *create_settings(const obs_source_info *info, const char *mode)
+    {
+        auto settings = obs_data_create();
+        info->get_defaults(settings);
+        obs_data_set_string(settings, P_AUDIO_SRC, P_OUTPUT_BUS);
+        obs_data_set_string(settings, P_DISPLAY_MODE, mode);
+        obs_data_set_string(settings, P_CHANNEL_MODE, P_STEREO);
+        obs_data_set_int(settings, P_HEIGHT, HEIGHT);
+        return settings;
+    }
+
+    int regression(const obs_source_info *info, int frames)
+    {
+        const auto path = (std::filesystem::temp_directory_path() / "waveform_replay_test.wavlog").string();
+        auto failed = 0;
+        for(const auto& test : CASES)
+        {
+            auto settings = create_settings(info, test.mode);
+            test.setup(settings);
+            const auto live = run(settings, path.c_str(), frames);
+            const auto replayed = run(settings, path.c_str(), 0);
+            obs_data_release(settings);
+
+            const auto ok = (live != 0) && (live == replayed);
+            std::printf("%-28s %s (live %016llx, replay %016llx)\n", test.name, ok ? "ok" : "FAILED", (unsigned long long)live, (unsigned long long)replayed);
+            if(!ok)
+                ++failed;
+        }
+
+        // a log of another speaker layout is refused, the replay never starts
+        obs_audio_info mono{};
+        mono.samples_per_sec = SAMPLE_RATE;
+        mono.speakers = SPEAKERS_MONO;
+        CaptureRecorder recorder;
+        recorder.open(path.c_str(), mono);
+        recorder.close();
+        auto settings = create_settings(info, P_CURVE);
+        const auto refused = (run(settings, path.c_str(), 0) == 0);
+        obs_data_release(settings);
+        std::printf("%-28s %s\n", "other speaker layout", refused ? "ok" : "FAILED");
+        if(!refused)
+            ++failed;
+
+        std::filesystem::remove(path);
+        return failed;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    WAVSource::register_source();
+    const auto info = gs_stub::source_info();
+    if(info == nullptr)
+    {
+        std::fprintf(stderr, "source was not registered\n");
+        return 1;
+    }
+    gs_stub::hash_uploads(true);
+
+    // a number is the frame count of the regression test, anything else a log to replay
+    char *end = nullptr;
+    const auto frames = (argc > 1) ? std::strtol(argv[1], &end, 10) : 300;
+    auto failed = 0;
+    if((argc < 2) || (*end == '\0'))
+        failed = regression(info, std::max((int)frames, 1));
+    else
+    {
+        auto settings = create_settings(info, (argc > 2) ? argv[2] : P_CURVE);
+        const auto start = std::chrono::steady_clock::now();
+        const auto checksum = run(settings, argv[1], 0);
+        const auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        obs_data_release(settings);
+        std::printf("%s: last frame %016llx, %.1f ms\n", argv[1], (unsigned long long)checksum, ms);
+        failed = (checksum == 0) ? 1 : 0;
+    }
+
+    obs_enter_graphics();
+    vbuf_pool::clear();
+    obs_leave_graphics();
+    return (failed == 0) ? 0 : 1;
+}
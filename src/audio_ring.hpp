@@ -0,0 +1,155 @@
+/*
+    Copyright (C) 2024 Devin Davila
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include "aligned_buffer.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+// Lock-free single producer/single consumer ring of planar float audio.
+// The producer (audio callback) pushes packets along with the timestamp of the end of the packet,
+// the consumer (tick) reads back whatever is available.
+//
+// Frame counters are free running, positions are taken modulo CAPACITY.
+// If the consumer falls more than CAPACITY frames behind, the producer drops the packet
+// and flags an overrun, the consumer then discards everything and starts over.
+class AudioRing
+{
+public:
+    static constexpr size_t CAPACITY = 1u << 15;    // frames per channel, must be a power of two
+    static constexpr size_t MAX_CHANNELS = 2;
+
+    struct State
+    {
+        uint64_t available = 0; // frames that can be read
+        uint64_t end_ts = 0;    // timestamp of the end of the last frame written (0 if nothing was written yet)
+    };
+
+    AudioRing() = default;
+    AudioRing(const AudioRing&) = delete;
+    AudioRing& operator=(const AudioRing&) = delete;
+
+    // allocate the ring (if needed) and empty it, the producer must be detached
+    void init()
+    {
+        for(auto& i : m_data)
+            if(!i)
+                i.reset(CAPACITY);
+        clear();
+    }
+
+    // free the ring, the producer must be detached
+    void reset()
+    {
+        for(auto& i : m_data)
+            i.reset();
+        clear();
+    }
+
+    // the producer must be detached
+    void clear()
+    {
+        m_write.store(0, std::memory_order_relaxed);
+        m_read.store(0, std::memory_order_relaxed);
+        m_end_ts.store(0, std::memory_order_relaxed);
+        m_seq.store(0, std::memory_order_relaxed);
+        m_overrun.store(false, std::memory_order_relaxed);
+    }
+
+    explicit operator bool() const noexcept { return static_cast<bool>(m_data[0]); }
+
+    // producer, null planes are written as silence
+    void push(const float *const *planes, size_t channels, size_t frames, uint64_t end_ts)
+    {
+        const auto write = m_write.load(std::memory_order_relaxed);
+        const auto read = m_read.load(std::memory_order_acquire);
+        if((write - read) + frames > CAPACITY)
+        {
+            m_overrun.store(true, std::memory_order_relaxed);
+            return;
+        }
+
+        const auto pos = (size_t)(write & (CAPACITY - 1));
+        const auto first = std::min(frames, CAPACITY - pos);
+        for(size_t i = 0; i < std::min(channels, MAX_CHANNELS); ++i)
+        {
+            auto dst = m_data[i].get();
+            auto src = planes[i];
+            if(src == nullptr)
+            {
+                memset(&dst[pos], 0, first * sizeof(float));
+                memset(dst, 0, (frames - first) * sizeof(float));
+            }
+            else
+            {
+                memcpy(&dst[pos], src, first * sizeof(float));
+                memcpy(dst, &src[first], (frames - first) * sizeof(float));
+            }
+        }
+
+        // publish the frame count and timestamp together (seqlock)
+        m_seq.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_write.store(write + frames, std::memory_order_relaxed);
+        m_end_ts.store(end_ts, std::memory_order_relaxed);
+        m_seq.fetch_add(1, std::memory_order_release);
+    }
+
+    // consumer
+    State state()
+    {
+        if(m_overrun.exchange(false, std::memory_order_acquire))
+            m_read.store(m_write.load(std::memory_order_acquire), std::memory_order_release);
+
+        State ret;
+        uint64_t seq, write;
+        do
+        {
+            seq = m_seq.load(std::memory_order_acquire);
+            write = m_write.load(std::memory_order_relaxed);
+            ret.end_ts = m_end_ts.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+        } while((seq & 1) || (seq != m_seq.load(std::memory_order_relaxed)));
+
+        ret.available = write - m_read.load(std::memory_order_relaxed);
+        return ret;
+    }
+
+    // consumer, contiguous run of frames at the read position (at most 'frames', less if the ring wraps)
+    const float *peek(size_t channel, size_t frames, size_t& contiguous) const
+    {
+        const auto pos = (size_t)(m_read.load(std::memory_order_relaxed) & (CAPACITY - 1));
+        contiguous = std::min(frames, CAPACITY - pos);
+        return &m_data[channel][pos];
+    }
+
+    // consumer
+    void consume(uint64_t frames)
+    {
+        m_read.store(m_read.load(std::memory_order_relaxed) + frames, std::memory_order_release);
+    }
+
+private:
+    AlignedBuffer<float> m_data[MAX_CHANNELS];
+    std::atomic<uint64_t> m_write = 0;
+    std::atomic<uint64_t> m_read = 0;
+    std::atomic<uint64_t> m_end_ts = 0;
+    std::atomic<uint64_t> m_seq = 0;
+    std::atomic<bool> m_overrun = false;
+};
@@ -0,0 +1,143 @@
+/*
+    Copyright (C) 2024 Devin Davila
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include "waveform_config.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <numbers>
+
+#ifdef ENABLE_X86_SIMD
+#include <immintrin.h>
+#endif
+
+enum class MeterBallistics
+{
+    NONE,   // window RMS/peak with per-frame smoothing
+    VU,
+    PPM_I,  // IEC 60268-10 type I (DIN)
+    PPM_II  // IEC 60268-10 type II (BBC)
+};
+
+// Meter ballistics as per-sample attack/release filters on the rectified signal.
+// Runs on every new sample so the reading doesn't depend on the frame rate.
+// Both channels are filtered in the same vector, the recursion in time can't be vectorized.
+class Ballistics
+{
+public:
+    static constexpr size_t MAX_CHANNELS = 2;
+
+    void init(MeterBallistics type, uint32_t sample_rate)
+    {
+        // one-pole time constants in seconds
+        // VU: 99% of the reading after 300 ms, same going down
+        // PPM I: a 10 ms 5 kHz burst reads 1 dB low, falls 20 dB in 1.5 s
+        // PPM II: a 10 ms 5 kHz burst reads 4 dB low, falls 24 dB in 2.8 s
+        // (attack constants fitted numerically on the rectified tone, the release holds up the reading between peaks)
+        auto fall = [](double db, double t) { return t / ((db / 20.0) * std::log(10.0)); };
+        auto attack = 0.3 / std::log(100.0);
+        auto release = attack;
+        m_scale = 1.0f;
+        if(type == MeterBallistics::PPM_I)
+        {
+            attack = 0.0016;
+            release = fall(20.0, 1.5);
+        }
+        else if(type == MeterBallistics::PPM_II)
+        {
+            attack = 0.005;
+            release = fall(24.0, 2.8);
+        }
+        else
+            m_scale = (float)(std::numbers::pi / (2.0 * std::numbers::sqrt2)); // average responding, a sine reads its RMS
+
+        m_attack = (float)(1.0 - std::exp(-1.0 / (attack * sample_rate)));
+        m_release = (float)(1.0 - std::exp(-1.0 / (release * sample_rate)));
+        reset();
+    }
+
+    void reset()
+    {
+        for(auto& i : m_env)
+            i = 0.0f;
+    }
+
+    float value(size_t channel) const { return m_env[channel] * m_scale; }
+
+    void process(const float *const *planes, size_t channels, size_t frames)
+    {
+        for(size_t channel = 0; channel < std::min(channels, MAX_CHANNELS); ++channel)
+        {
+            auto env = m_env[channel];
+            auto src = planes[channel];
+            for(size_t i = 0; i < frames; ++i)
+            {
+                auto x = std::abs(src[i]);
+                env += ((x > env) ? m_attack : m_release) * (x - env);
+            }
+            m_env[channel] = env;
+        }
+    }
+
+#ifdef ENABLE_X86_SIMD
+    // channels in the low lanes, one sample of each per step
+    void process_sse(const float *const *planes, size_t channels, size_t frames)
+    {
+        const auto src0 = planes[0];
+        const auto src1 = (channels > 1) ? planes[1] : planes[0];
+        const auto signbit = _mm_set1_ps(-0.0f);
+        const auto attack = _mm_set1_ps(m_attack);
+        const auto release = _mm_set1_ps(m_release);
+        auto env = _mm_setr_ps(m_env[0], m_env[1], 0.0f, 0.0f);
+        auto step = [&](__m128 x) {
+            auto coef = _mm_cmpgt_ps(x, env);
+            coef = _mm_or_ps(_mm_and_ps(coef, attack), _mm_andnot_ps(coef, release));
+            env = _mm_add_ps(env, _mm_mul_ps(coef, _mm_sub_ps(x, env)));
+        };
+
+        const auto max = frames & -4;
+        size_t i = 0;
+        for(; i < max; i += 4)
+        {
+            // [a0 b0 a1 b1] [a2 b2 a3 b3]
+            auto a = _mm_andnot_ps(signbit, _mm_loadu_ps(&src0[i]));
+            auto b = _mm_andnot_ps(signbit, _mm_loadu_ps(&src1[i]));
+            auto lo = _mm_unpacklo_ps(a, b);
+            auto hi = _mm_unpackhi_ps(a, b);
+            step(lo);
+            step(_mm_movehl_ps(lo, lo));
+            step(hi);
+            step(_mm_movehl_ps(hi, hi));
+        }
+        for(; i < frames; ++i)
+            step(_mm_andnot_ps(signbit, _mm_unpacklo_ps(_mm_load_ss(&src0[i]), _mm_load_ss(&src1[i]))));
+
+        alignas(16) float out[4];
+        _mm_store_ps(out, env);
+        m_env[0] = out[0];
+        m_env[1] = out[1];
+    }
+#endif // ENABLE_X86_SIMD
+
+private:
+    float m_attack = 1.0f;
+    float m_release = 1.0f;
+    float m_scale = 1.0f;
+    float m_env[MAX_CHANNELS] = {};
+};
@@ -0,0 +1,235 @@
+/*
+    Copyright (C) 2024 Devin Davila
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "calibration.hpp"
+#include "fft.hpp"
+#include "log.hpp"
+#include <obs-module.h>
+#include <util/platform.h>
+#include <fftw3.h>
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <vector>
+
+#ifdef ENABLE_X86_SIMD
+
+namespace calibration
+{
+    static constexpr int CACHE_VERSION = 1;
+    static constexpr int MAX_KERNEL = 192;                                  // gauss kernel size at the maximum filter radius is 191
+    static constexpr int KERNEL_SIZES[] = { 3, 5, 9, 17, 33, 65, 129, 191 }; // sizes actually timed, the rest use the nearest smaller one
+    static constexpr size_t NUM_FFT_SIZES = 6;                              // RealFFT::MIN_SIZE to RealFFT::MAX_SIZE
+
+    static bool s_calibrated = false;
+    static FilterVariant s_filter[MAX_KERNEL]{};
+    static bool s_builtin_fft[NUM_FFT_SIZES]{};
+
+    static size_t fft_index(size_t fft_size)
+    {
+        size_t idx = 0;
+        for(auto sz = RealFFT::MIN_SIZE; sz < fft_size; sz *= 2)
+            ++idx;
+        return idx;
+    }
+
+    // best of 5 runs of 'reps' calls
+    template<typename F>
+    static uint64_t time_ns(F&& fn, int reps)
+    {
+        auto best = std::numeric_limits<uint64_t>::max();
+        for(auto run = 0; run < 5; ++run)
+        {
+            auto start = os_gettime_ns();
+            for(auto i = 0; i < reps; ++i)
+                fn();
+            best = std::min(best, os_gettime_ns() - start);
+        }
+        return best;
+    }
+
+    static FilterVariant time_filter(int kernel_size, const std::vector<float>& samples, std::vector<float>& output)
+    {
+        const auto w = (kernel_size + 1) / 2;
+        auto kernel = make_gauss_kernel(((float)w - 0.5f) / 3.0f);
+        auto best = FilterVariant::SCALAR;
+        auto best_time = std::numeric_limits<uint64_t>::max();
+        for(auto variant : { FilterVariant::SCALAR, FilterVariant::SSE, FilterVariant::AVX })
+        {
+            auto t = time_ns([&]() { apply_filter_fma3(samples, kernel, output, variant); }, 4);
+            if(t < best_time)
+            {
+                best_time = t;
+                best = variant;
+            }
+        }
+        return best;
+    }
+
+    static bool time_fft(size_t fft_size)
+    {
+        AlignedBuffer<float> input, window, output;
+        AlignedBuffer<fftwf_complex> spectrum;
+        input.reset(fft_size);
+        window.reset(fft_size);
+        output.reset(fft_size / 2);
+        spectrum.reset(fft_size);
+        for(size_t i = 0; i < fft_size; ++i)
+        {
+            input[i] = std::sin((float)i * 0.37f);
+            window[i] = 0.5f;
+        }
+
+        RealFFT rfft;
+        if(!rfft.init(fft_size))
+            return false;
+        auto plan = fftwf_plan_dft_r2c_1d((int)fft_size, input.get(), spectrum.get(), FFTW_ESTIMATE);
+        if(plan == nullptr)
+            return true;
+
+        // input is overwritten by the window multiply, the values don't matter for timing
+        auto fftw_time = time_ns([&]() {
+            for(size_t i = 0; i < fft_size; ++i)
+                input[i] *= window[i];
+            fftwf_execute(plan);
+            for(size_t i = 0; i < fft_size / 2; ++i)
+                output[i] = std::sqrt((spectrum[i][0] * spectrum[i][0]) + (spectrum[i][1] * spectrum[i][1]));
+        }, 8);
+        auto rfft_time = time_ns([&]() { rfft.magnitudes(input.get(), window.get(), 1.0f, output.get(), 0, fft_size / 2); }, 8);
+        fftwf_destroy_plan(plan);
+
+        return rfft_time <= fftw_time;
+    }
+
+    static void fill_filter_table(const FilterVariant (&results)[std::size(KERNEL_SIZES)])
+    {
+        for(auto size = 0; size < MAX_KERNEL; ++size)
+        {
+            auto idx = 0u;
+            while(((idx + 1) < std::size(KERNEL_SIZES)) && (KERNEL_SIZES[idx + 1] <= size))
+                ++idx;
+            s_filter[size] = results[idx];
+        }
+    }
+
+    static bool load_cache(const char *path, const char *cpu_id)
+    {
+        auto data = obs_data_create_from_json_file(path);
+        if(data == nullptr)
+            return false;
+
+        bool valid = (obs_data_get_int(data, "cache_version") == CACHE_VERSION)
+            && (std::string(obs_data_get_string(data, "plugin_version")) == WAVEFORM_VERSION)
+            && (std::string(obs_data_get_string(data, "cpu")) == cpu_id);
+
+        FilterVariant results[std::size(KERNEL_SIZES)]{};
+        for(auto i = 0u; valid && (i < std::size(KERNEL_SIZES)); ++i)
+        {
+            auto key = "filter_" + std::to_string(KERNEL_SIZES[i]);
+            auto val = obs_data_get_int(data, key.c_str());
+            valid = obs_data_has_user_value(data, key.c_str()) && (val >= 0) && (val <= (long long)FilterVariant::AVX);
+            results[i] = (FilterVariant)val;
+        }
+        for(auto i = 0u; valid && (i < NUM_FFT_SIZES); ++i)
+        {
+            auto key = "builtin_fft_" + std::to_string(RealFFT::MIN_SIZE << i);
+            valid = obs_data_has_user_value(data, key.c_str());
+            s_builtin_fft[i] = obs_data_get_bool(data, key.c_str());
+        }
+        obs_data_release(data);
+
+        if(valid)
+            fill_filter_table(results);
+        return valid;
+    }
+
+    static void save_cache(const char *path, const char *cpu_id, const FilterVariant (&results)[std::size(KERNEL_SIZES)])
+    {
+        auto data = obs_data_create();
+        obs_data_set_int(data, "cache_version", CACHE_VERSION);
+        obs_data_set_string(data, "plugin_version", WAVEFORM_VERSION);
+        obs_data_set_string(data, "cpu", cpu_id);
+        for(auto i = 0u; i < std::size(KERNEL_SIZES); ++i)
+            obs_data_set_int(data, ("filter_" + std::to_string(KERNEL_SIZES[i])).c_str(), (long long)results[i]);
+        for(auto i = 0u; i < NUM_FFT_SIZES; ++i)
+            obs_data_set_bool(data, ("builtin_fft_" + std::to_string(RealFFT::MIN_SIZE << i)).c_str(), s_builtin_fft[i]);
+        if(!obs_data_save_json_safe(data, path, "tmp", "bak"))
+            LogWarn << "Failed to save calibration cache: \"" << path << "\"";
+        obs_data_release(data);
+    }
+
+    void init(const char *cpu_id, bool avx, bool avx2)
+    {
+        if(!avx)
+            return;
+
+        auto dir = obs_module_config_path("");
+        if(dir != nullptr)
+        {
+            os_mkdirs(dir);
+            bfree(dir);
+        }
+        auto path = obs_module_config_path("calibration.json");
+        if((path != nullptr) && load_cache(path, cpu_id))
+        {
+            s_calibrated = true;
+            bfree(path);
+            return;
+        }
+
+        const auto start = os_gettime_ns();
+
+        // gauss filter over a typical source width
+        std::vector<float> samples(1024), output(1024);
+        for(size_t i = 0; i < samples.size(); ++i)
+            samples[i] = std::sin((float)i * 0.1f);
+        FilterVariant results[std::size(KERNEL_SIZES)]{};
+        for(auto i = 0u; i < std::size(KERNEL_SIZES); ++i)
+            results[i] = time_filter(KERNEL_SIZES[i], samples, output);
+        fill_filter_table(results);
+
+        for(auto i = 0u; i < NUM_FFT_SIZES; ++i)
+            s_builtin_fft[i] = avx2 && time_fft(RealFFT::MIN_SIZE << i);
+
+        s_calibrated = true;
+        LogInfo << "Calibrated SIMD kernels in " << (double)(os_gettime_ns() - start) / 1000000.0 << " ms";
+
+        if(path != nullptr)
+        {
+            save_cache(path, cpu_id, results);
+            bfree(path);
+        }
+    }
+
+    FilterVariant filter_variant(const Kernel<float>& kernel)
+    {
+        if(!s_calibrated)
+            return (kernel.sse_size >= 8) ? FilterVariant::SSE : FilterVariant::SCALAR; // make sure we get at least 2 SIMD iterations
+        return s_filter[std::clamp(kernel.size, 0, MAX_KERNEL - 1)];
+    }
+
+    bool prefer_builtin_fft(size_t fft_size)
+    {
+        if(!s_calibrated || !RealFFT::supported(fft_size))
+            return RealFFT::supported(fft_size);
+        return s_builtin_fft[fft_index(fft_size)];
+    }
+}
+
+#endif // ENABLE_X86_SIMD
@@ -0,0 +1,35 @@
+/*
+    Copyright (C) 2024 Devin Davila
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include "filter.hpp"
+#include <cstddef>
+
+#ifdef ENABLE_X86_SIMD
+
+// One-time timing of the SIMD kernel variants on the host CPU.
+// Runs at module load (a few ms), results are cached in the module config directory
+// keyed by CPU id and plugin version. Until init() runs the static defaults are used.
+namespace calibration
+{
+    void init(const char *cpu_id, bool avx, bool avx2);
+
+    FilterVariant filter_variant(const Kernel<float>& kernel);
+    bool prefer_builtin_fft(size_t fft_size);   // RealFFT vs FFTW (AVX2 only)
+}
+
+#endif // ENABLE_X86_SIMD
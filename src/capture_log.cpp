@@ -0,0 +1,174 @@
+/*
+    Copyright (C) 2024 Devin Davila
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "capture_log.hpp"
+#include "log.hpp"
+#include <util/platform.h>
+#include <cstring>
+#include <cmath>
+
+static constexpr char LOG_MAGIC[8] = { 'W', 'A', 'V', 'C', 'A', 'P', 'L', 'G' };
+static constexpr uint32_t LOG_VERSION = 2; // 2: raw packets per mix input instead of the mixed packets
+
+bool CaptureRecorder::open(const char *path, const obs_audio_info& info)
+{
+    std::lock_guard lock(m_mtx);
+    if(m_file != nullptr)
+        fclose(m_file);
+
+    m_file = os_fopen(path, "wb");
+    if(m_file == nullptr)
+    {
+        m_active = false;
+        LogWarn << "Failed to open capture log: \"" << path << "\"";
+        return false;
+    }
+
+    CaptureLogHeader header{};
+    memcpy(header.magic, LOG_MAGIC, sizeof(header.magic));
+    header.version = LOG_VERSION;
+    header.samples_per_sec = info.samples_per_sec;
+    header.speakers = (uint32_t)info.speakers;
+    fwrite(&header, sizeof(header), 1, m_file);
+
+    m_active = true;
+    LogInfo << "Recording audio capture to \"" << path << "\"";
+    return true;
+}
+
+void CaptureRecorder::close()
+{
+    std::lock_guard lock(m_mtx);
+    m_active = false;
+    if(m_file != nullptr)
+    {
+        fclose(m_file);
+        m_file = nullptr;
+    }
+}
+
+void CaptureRecorder::write_packet(uint8_t source, uint64_t time_ns, const audio_data *audio, bool muted, uint32_t channels)
+{
+    std::lock_guard lock(m_mtx);
+    if(m_file == nullptr)
+        return;
+
+    CaptureLogRecord rec{};
+    rec.type = CaptureRecordType::PACKET;
+    rec.source = source;
+    rec.muted = muted ? 1 : 0;
+    rec.frames = audio->frames;
+    rec.time_ns = time_ns;
+    rec.audio_ts = audio->timestamp;
+    for(auto i = 0u; (i < channels) && (i < MAX_AV_PLANES); ++i)
+        if(audio->data[i] != nullptr)
+            rec.planes |= (uint8_t)(1u << i);
+
+    fwrite(&rec, sizeof(rec), 1, m_file);
+    for(auto i = 0u; (i < channels) && (i < MAX_AV_PLANES); ++i)
+        if(audio->data[i] != nullptr)
+            fwrite(audio->data[i], sizeof(float), audio->frames, m_file);
+}
+
+void CaptureRecorder::write_tick(uint64_t time_ns, float seconds)
+{
+    std::lock_guard lock(m_mtx);
+    if(m_file == nullptr)
+        return;
+
+    CaptureLogRecord rec{};
+    rec.type = CaptureRecordType::TICK;
+    rec.frames = (uint32_t)std::lround(seconds * 1000000.0f);
+    rec.time_ns = time_ns;
+    fwrite(&rec, sizeof(rec), 1, m_file);
+}
+
+bool CaptureReplay::open(const char *path)
+{
+    close();
+
+    m_file = os_fopen(path, "rb");
+    if(m_file == nullptr)
+    {
+        LogWarn << "Failed to open capture log: \"" << path << "\"";
+        return false;
+    }
+
+    if((fread(&m_header, sizeof(m_header), 1, m_file) != 1) || (memcmp(m_header.magic, LOG_MAGIC, sizeof(LOG_MAGIC)) != 0) || (m_header.version != LOG_VERSION))
+    {
+        LogWarn << "Invalid capture log: \"" << path << "\"";
+        close();
+        return false;
+    }
+
+    auto first = peek();
+    m_start_ts = (first != nullptr) ? first->time_ns : 0;
+    return true;
+}
+
+void CaptureReplay::close()
+{
+    if(m_file != nullptr)
+    {
+        fclose(m_file);
+        m_file = nullptr;
+    }
+    m_have_record = false;
+    m_start_ts = 0;
+}
+
+const CaptureLogRecord *CaptureReplay::peek()
+{
+    if(m_have_record)
+        return &m_record;
+    if(m_file == nullptr)
+        return nullptr;
+
+    if(fread(&m_record, sizeof(m_record), 1, m_file) != 1)
+    {
+        close(); // end of log
+        return nullptr;
+    }
+
+    if(m_record.type == CaptureRecordType::PACKET)
+    {
+        m_packet = {};
+        m_packet.frames = m_record.frames;
+        m_packet.timestamp = m_record.audio_ts;
+        for(auto i = 0u; i < MAX_AV_PLANES; ++i)
+        {
+            if((m_record.planes & (1u << i)) == 0)
+                continue;
+            if(m_planes[i].size() < m_record.frames)
+                m_planes[i].resize(m_record.frames);
+            if(fread(m_planes[i].data(), sizeof(float), m_record.frames, m_file) != m_record.frames)
+            {
+                close(); // truncated log
+                return nullptr;
+            }
+            m_packet.data[i] = (uint8_t*)m_planes[i].data();
+        }
+    }
+    else if(m_record.type != CaptureRecordType::TICK)
+    {
+        close(); // corrupt log
+        return nullptr;
+    }
+
+    m_have_record = true;
+    return &m_record;
+}
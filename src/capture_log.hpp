@@ -0,0 +1,116 @@
+/*
+    Copyright (C) 2024 Devin Davila
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <obs-module.h>
+#include <cstdint>
+#include <cstdio>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+// Binary log of the raw packets the audio capture callbacks receive and of the ticks that drain them.
+// Used to reproduce the exact packet timing, mute flags and timestamps seen on another machine.
+//
+// Layout: CaptureLogHeader, followed by a stream of CaptureLogRecord.
+// Packet records are followed by one plane of 'frames' floats for each bit set in 'planes'.
+// All values are native endian.
+
+enum class CaptureRecordType : uint8_t
+{
+    PACKET,
+    TICK
+};
+
+struct CaptureLogHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t samples_per_sec;
+    uint32_t speakers;
+    uint32_t reserved;
+};
+
+struct CaptureLogRecord
+{
+    CaptureRecordType type;
+    uint8_t source;     // index of the mix input this packet came from
+    uint8_t muted;
+    uint8_t planes;     // bitmask of planes stored after the record (null planes are omitted)
+    uint32_t frames;    // audio frames for packets, tick interval in microseconds for ticks
+    uint64_t time_ns;   // os_gettime_ns() when the packet was received or the tick started
+    uint64_t audio_ts;  // audio_data::timestamp (packets only)
+};
+
+static_assert(sizeof(CaptureLogRecord) == 24, "CaptureLogRecord must be tightly packed");
+
+// thread safe, packets and ticks arrive on different threads
+class CaptureRecorder
+{
+public:
+    CaptureRecorder() = default;
+    ~CaptureRecorder() { close(); }
+
+    CaptureRecorder(const CaptureRecorder&) = delete;
+    CaptureRecorder& operator=(const CaptureRecorder&) = delete;
+
+    bool open(const char *path, const obs_audio_info& info);
+    void close();
+    bool active() const { return m_active.load(std::memory_order_relaxed); }
+
+    void write_packet(uint8_t source, uint64_t time_ns, const audio_data *audio, bool muted, uint32_t channels);
+    void write_tick(uint64_t time_ns, float seconds);
+
+private:
+    std::mutex m_mtx;
+    FILE *m_file = nullptr;
+    std::atomic<bool> m_active = false;
+};
+
+// sequential reader
+class CaptureReplay
+{
+public:
+    CaptureReplay() = default;
+    ~CaptureReplay() { close(); }
+
+    CaptureReplay(const CaptureReplay&) = delete;
+    CaptureReplay& operator=(const CaptureReplay&) = delete;
+
+    bool open(const char *path);
+    void close();
+
+    const CaptureLogHeader& header() const { return m_header; }
+
+    // returns the next record without consuming it, or nullptr at the end of the log
+    // for packets the audio data is available through packet() until pop() is called
+    const CaptureLogRecord *peek();
+    void pop() { m_have_record = false; }
+
+    const audio_data& packet() const { return m_packet; }
+
+    uint64_t start_ts() const { return m_start_ts; }
+
+private:
+    FILE *m_file = nullptr;
+    CaptureLogHeader m_header{};
+    CaptureLogRecord m_record{};
+    bool m_have_record = false;
+    uint64_t m_start_ts = 0;
+    audio_data m_packet{};
+    std::vector<float> m_planes[MAX_AV_PLANES];
+};
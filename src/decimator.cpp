@@ -0,0 +1,104 @@
+/*
+    Copyright (C) 2024 Devin Davila
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "decimator.hpp"
+#include <algorithm>
+#include <cstring>
+
+void Decimator::init(int factor, bool fma3)
+{
+    m_factor = std::max(factor, 1);
+    m_fma3 = fma3;
+    if(m_factor > 1)
+    {
+        m_kernel = make_lowpass_kernel<float>(m_factor);
+        m_history = (size_t)m_kernel.size - 1;
+        m_buf.reset(m_history + MAX_BLOCK);
+    }
+    else
+    {
+        m_kernel = {};
+        m_history = 0;
+        m_buf.reset();
+    }
+    reset();
+}
+
+void Decimator::reset()
+{
+    if(m_buf != nullptr)
+        std::fill(m_buf.get(), m_buf.get() + m_history, 0.0f);
+    m_phase = 0;
+}
+
+size_t Decimator::process(const float *in, size_t count, float *out)
+{
+    if(m_factor <= 1)
+    {
+        memcpy(out, in, count * sizeof(float));
+        return count;
+    }
+
+    const auto factor = (size_t)m_factor;
+    size_t written = 0;
+    while(count > 0)
+    {
+        const auto block = std::min(count, MAX_BLOCK);
+        memcpy(&m_buf[m_history], in, block * sizeof(float));
+
+        // outputs whose taps lie entirely inside history + block
+        const auto avail = m_history + block;
+        if(avail >= m_phase + (size_t)m_kernel.size)
+        {
+            const auto n = ((avail - m_phase - (size_t)m_kernel.size) / factor) + 1;
+#ifdef ENABLE_X86_SIMD
+            if(m_fma3)
+                decimate_fma3(&m_buf[m_phase], n, factor, m_kernel, &out[written]);
+            else
+                decimate(&m_buf[m_phase], n, factor, m_kernel, &out[written]);
+#else
+            decimate(&m_buf[m_phase], n, factor, m_kernel, &out[written]);
+#endif
+            written += n;
+            m_phase += n * factor;
+        }
+
+        // keep the tail as history for the next block
+        memmove(m_buf.get(), &m_buf[block], m_history * sizeof(float));
+        m_phase -= block;
+        in += block;
+        count -= block;
+    }
+
+    return written;
+}
+
+size_t Decimator::skip(size_t count)
+{
+    if(m_factor <= 1)
+        return count;
+
+    // same output count as process() would produce, but the history is simply cleared
+    const auto factor = (size_t)m_factor;
+    const auto avail = m_history + count;
+    size_t n = 0;
+    if(avail >= m_phase + (size_t)m_kernel.size)
+        n = ((avail - m_phase - (size_t)m_kernel.size) / factor) + 1;
+    m_phase = m_phase + (n * factor) - count;
+    std::fill(m_buf.get(), m_buf.get() + m_history, 0.0f);
+    return n;
+}
@@ -0,0 +1,49 @@
+/*
+    Copyright (C) 2024 Devin Davila
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include "filter.hpp"
+#include <cstddef>
+
+// Streaming lowpass + downsample by an integer factor.
+// Filter history and the output phase carry over between calls,
+// so packets of any size can be fed in as they arrive.
+class Decimator
+{
+public:
+    static constexpr size_t MAX_BLOCK = 1024; // input samples processed per filter pass
+
+    void init(int factor, bool fma3);
+    void reset();   // clear history, e.g. after a gap in the input
+
+    int factor() const noexcept { return m_factor; }
+    size_t delay() const noexcept { return m_history - (size_t)m_kernel.radius; } // input samples from the newest output's center to the newest input
+
+    // returns the number of output samples written, at most (count / factor) + 1
+    size_t process(const float *in, size_t count, float *out);
+
+    // advance over 'count' silent samples without filtering them, returns the number of output samples they correspond to
+    size_t skip(size_t count);
+
+private:
+    int m_factor = 1;
+    bool m_fma3 = false;
+    Kernel<float> m_kernel;
+    AlignedBuffer<float> m_buf;     // kernel.size - 1 samples of history followed by the current block
+    size_t m_history = 0;
+    size_t m_phase = 0;             // offset of the next output's first tap relative to the start of m_buf
+};
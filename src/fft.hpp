@@ -0,0 +1,59 @@
+/*
+    Copyright (C) 2024 Devin Davila
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include "aligned_buffer.hpp"
+#include <cstddef>
+#include <cstdint>
+
+// In-tree real FFT for small power-of-two sizes, AVX2/FMA3 only.
+// N real samples are packed into N/2 complex values, transformed with an iterative
+// radix-2 FFT in split real/imaginary layout, then untangled into the N/2 real spectrum bins.
+// The window multiply happens while loading and only the scaled magnitudes are written out,
+// so no interleaved complex output buffer is needed.
+// Sizes outside [MIN_SIZE, MAX_SIZE] or not a power of two are left to FFTW.
+
+class RealFFT
+{
+public:
+    static constexpr size_t MIN_SIZE = 128;
+    static constexpr size_t MAX_SIZE = 4096;
+
+    static bool supported(size_t size) { return (size >= MIN_SIZE) && (size <= MAX_SIZE) && ((size & (size - 1)) == 0); }
+
+    // returns false if the size is not supported
+    bool init(size_t size);
+    void reset();
+
+    explicit operator bool() const noexcept { return m_size > 0; }
+    size_t size() const noexcept { return m_size; }
+
+    // out[k - first] = |FFT(in * window)[k]| * coefficient, for k in [first, first + count)
+    // first and count must be multiples of 8 within [0, N/2], window may be nullptr, out must be 32-byte aligned
+    void magnitudes(const float *in, const float *window, float coefficient, float *out, size_t first, size_t count);
+
+private:
+    size_t m_size = 0;                  // real input size N
+    size_t m_half = 0;                  // complex FFT size N/2
+    AlignedBuffer<float> m_re;          // work buffers, N/2 + 8 (padded for the reversed loads)
+    AlignedBuffer<float> m_im;
+    AlignedBuffer<float> m_tw_re;       // per-stage twiddles, stage with half-length h starts at index h
+    AlignedBuffer<float> m_tw_im;
+    AlignedBuffer<float> m_post_re;     // exp(-2*pi*i*k/N) for untangling the packed spectrum
+    AlignedBuffer<float> m_post_im;
+    AlignedBuffer<uint16_t> m_bitrev;
+};
@@ -0,0 +1,191 @@
+/*
+    Copyright (C) 2024 Devin Davila
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "fft.hpp"
+#include <numbers>
+#include <immintrin.h>
+#include <cmath>
+#include <cassert>
+
+bool RealFFT::init(size_t size)
+{
+    reset();
+    if(!supported(size))
+        return false;
+
+    const auto half = size / 2;
+    m_re.reset(half + 8);
+    m_im.reset(half + 8);
+    m_tw_re.reset(half);
+    m_tw_im.reset(half);
+    m_post_re.reset(half);
+    m_post_im.reset(half);
+    m_bitrev.reset(half);
+
+    // twiddles in double precision to keep the error down at 4096
+    for(size_t h = 1; h < half; h *= 2)
+    {
+        for(size_t j = 0; j < h; ++j)
+        {
+            auto theta = -std::numbers::pi * (double)j / (double)h;
+            m_tw_re[h + j] = (float)std::cos(theta);
+            m_tw_im[h + j] = (float)std::sin(theta);
+        }
+    }
+    m_tw_re[0] = m_tw_im[0] = 0.0f; // unused
+
+    for(size_t k = 0; k < half; ++k)
+    {
+        auto theta = -2.0 * std::numbers::pi * (double)k / (double)size;
+        m_post_re[k] = (float)std::cos(theta);
+        m_post_im[k] = (float)std::sin(theta);
+    }
+
+    auto bits = 0u;
+    while(((size_t)1 << bits) < half)
+        ++bits;
+    for(size_t i = 0; i < half; ++i)
+    {
+        size_t r = 0;
+        for(auto b = 0u; b < bits; ++b)
+            if(i & ((size_t)1 << b))
+                r |= (size_t)1 << (bits - 1 - b);
+        m_bitrev[i] = (uint16_t)r;
+    }
+
+    m_size = size;
+    m_half = half;
+    return true;
+}
+
+void RealFFT::reset()
+{
+    m_re.reset();
+    m_im.reset();
+    m_tw_re.reset();
+    m_tw_im.reset();
+    m_post_re.reset();
+    m_post_im.reset();
+    m_bitrev.reset();
+    m_size = 0;
+    m_half = 0;
+}
+
+void RealFFT::magnitudes(const float *in, const float *window, float coefficient, float *out, size_t first, size_t count)
+{
+    constexpr auto step = sizeof(__m256) / sizeof(float);
+    const auto M = m_half;
+    auto re = m_re.get();
+    auto im = m_im.get();
+
+    // pack x[2n] + i*x[2n+1] in bit-reversed order, applying the window on the way
+    if(window != nullptr)
+    {
+        for(size_t n = 0; n < M; ++n)
+        {
+            auto r = m_bitrev[n];
+            re[r] = in[2 * n] * window[2 * n];
+            im[r] = in[(2 * n) + 1] * window[(2 * n) + 1];
+        }
+    }
+    else
+    {
+        for(size_t n = 0; n < M; ++n)
+        {
+            auto r = m_bitrev[n];
+            re[r] = in[2 * n];
+            im[r] = in[(2 * n) + 1];
+        }
+    }
+
+    // first three stages are too narrow for 8-wide butterflies
+    for(size_t h = 1; h < step; h *= 2)
+    {
+        for(size_t base = 0; base < M; base += 2 * h)
+        {
+            for(size_t j = 0; j < h; ++j)
+            {
+                auto a = base + j;
+                auto b = a + h;
+                auto wr = m_tw_re[h + j];
+                auto wi = m_tw_im[h + j];
+                auto tr = (re[b] * wr) - (im[b] * wi);
+                auto ti = (re[b] * wi) + (im[b] * wr);
+                re[b] = re[a] - tr;
+                im[b] = im[a] - ti;
+                re[a] += tr;
+                im[a] += ti;
+            }
+        }
+    }
+
+    for(size_t h = step; h < M; h *= 2)
+    {
+        for(size_t base = 0; base < M; base += 2 * h)
+        {
+            for(size_t j = 0; j < h; j += step)
+            {
+                auto a = base + j;
+                auto b = a + h;
+                auto wr = _mm256_load_ps(&m_tw_re[h + j]);
+                auto wi = _mm256_load_ps(&m_tw_im[h + j]);
+                auto ar = _mm256_load_ps(&re[a]);
+                auto ai = _mm256_load_ps(&im[a]);
+                auto br = _mm256_load_ps(&re[b]);
+                auto bi = _mm256_load_ps(&im[b]);
+                auto tr = _mm256_fmsub_ps(br, wr, _mm256_mul_ps(bi, wi));
+                auto ti = _mm256_fmadd_ps(br, wi, _mm256_mul_ps(bi, wr));
+                _mm256_store_ps(&re[a], _mm256_add_ps(ar, tr));
+                _mm256_store_ps(&im[a], _mm256_add_ps(ai, ti));
+                _mm256_store_ps(&re[b], _mm256_sub_ps(ar, tr));
+                _mm256_store_ps(&im[b], _mm256_sub_ps(ai, ti));
+            }
+        }
+    }
+
+    // untangle the packed spectrum
+    // Z[k] = E[k] + i*O[k], where E/O are the spectra of the even/odd samples
+    // E[k] = (Z[k] + conj(Z[M-k])) / 2
+    // O[k] = (Z[k] - conj(Z[M-k])) / 2i
+    // X[k] = E[k] + exp(-2*pi*i*k/N) * O[k]
+    re[M] = re[0]; // Z[M] wraps to Z[0]
+    im[M] = im[0];
+    const auto reverse = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+    const auto half = _mm256_set1_ps(0.5f);
+    const auto coeff = _mm256_set1_ps(coefficient);
+    assert(((first % step) == 0) && ((count % step) == 0) && ((first + count) <= M));
+    for(size_t k = first; k < (first + count); k += step)
+    {
+        auto zr = _mm256_load_ps(&re[k]);
+        auto zi = _mm256_load_ps(&im[k]);
+        auto cr = _mm256_permutevar8x32_ps(_mm256_loadu_ps(&re[M - k - 7]), reverse); // Z[M-k]
+        auto ci = _mm256_permutevar8x32_ps(_mm256_loadu_ps(&im[M - k - 7]), reverse);
+
+        auto er = _mm256_mul_ps(_mm256_add_ps(zr, cr), half);
+        auto ei = _mm256_mul_ps(_mm256_sub_ps(zi, ci), half);
+        auto or_ = _mm256_mul_ps(_mm256_add_ps(zi, ci), half);
+        auto oi = _mm256_mul_ps(_mm256_sub_ps(cr, zr), half);
+
+        auto wr = _mm256_load_ps(&m_post_re[k]);
+        auto wi = _mm256_load_ps(&m_post_im[k]);
+        auto xr = _mm256_add_ps(er, _mm256_fmsub_ps(or_, wr, _mm256_mul_ps(oi, wi)));
+        auto xi = _mm256_add_ps(ei, _mm256_fmadd_ps(or_, wi, _mm256_mul_ps(oi, wr)));
+
+        auto mag = _mm256_sqrt_ps(_mm256_fmadd_ps(xi, xi, _mm256_mul_ps(xr, xr)));
+        _mm256_store_ps(&out[k - first], _mm256_mul_ps(mag, coeff));
+    }
+}
@@ -20,6 +20,7 @@
 #include "aligned_buffer.hpp"
 #include "math_funcs.hpp"
 #include <cmath>
+#include <cassert>
 #include <cstdint>
 #include <vector>
 #include <type_traits>
@@ -35,6 +36,7 @@ struct Kernel
     int sse_size = 0;
     int avx_size = 0;
     T sum = (T)0;
+    AlignedBuffer<T> tap_major; // optional copy of per-point weights, tap-major in groups of 8 points (see make_tap_major())
 };
 
 template<typename T>
@@ -130,6 +132,63 @@ Kernel<T> make_lanczos_kernel(const std::vector<T>& indices, const intmax_t radi
     return ret;
 }
 
+// windowed sinc lowpass (blackman) for decimating by 'factor'
+// -6 dB at the output nyquist, flat to 80% of it and -75 dB from 120% on, so nothing aliases below 80%
+// 28 * factor + 1 taps, zero padded to a multiple of 8 on the oldest side so the padding adds no delay
+// radius is the index of the center tap, the newest output lags the newest input by size - 1 - radius = 14 * factor samples
+template<typename T>
+Kernel<T> make_lowpass_kernel(int factor)
+{
+    Kernel<T> ret;
+    if(factor < 2)
+        return ret;
+    const auto taps = (28 * factor) | 1;
+    const auto size = (taps + 7) & -8;
+    const auto pad = size - taps;
+    ret.weights.reset(size);
+    ret.radius = pad + (taps / 2);
+    ret.size = size;
+    ret.sse_size = size & -(16 / (int)sizeof(T));
+    ret.avx_size = size & -(32 / (int)sizeof(T));
+    constexpr auto pi = std::numbers::pi_v<T>;
+    const auto fc = (T)0.5 / (T)factor;
+    const auto N = (T)(taps - 1);
+    for(auto i = 0; i < pad; ++i)
+        ret.weights[i] = (T)0;
+    for(auto i = 0; i < taps; ++i)
+    {
+        auto n = (T)(i - (taps / 2));
+        auto window = (T)0.42 - ((T)0.5 * std::cos((2 * pi * i) / N)) + ((T)0.08 * std::cos((4 * pi * i) / N));
+        ret.weights[pad + i] = (T)2 * fc * sinc((T)2 * fc * n) * window;
+        ret.sum += ret.weights[pad + i];
+    }
+    for(auto i = pad; i < size; ++i)
+        ret.weights[i] /= ret.sum; // unity gain at DC
+    ret.sum = (T)1;
+    return ret;
+}
+
+// regroup the weights of a per-point (interpolation) kernel so each tap of 8 consecutive points is contiguous
+// tap_major[(((group * size) + tap) * 8) + lane] = weights[(((group * 8) + lane) * size) + tap]
+// only whole groups are stored, trailing points keep using the point-major weights
+template<typename T>
+void make_tap_major(Kernel<T>& kernel, size_t points)
+{
+    constexpr size_t group = 8;
+    const auto groups = points / group;
+    const auto size = (size_t)kernel.size;
+    if((groups == 0) || (size == 0))
+    {
+        kernel.tap_major.reset();
+        return;
+    }
+    kernel.tap_major.reset(groups * group * size);
+    for(size_t g = 0; g < groups; ++g)
+        for(size_t t = 0; t < size; ++t)
+            for(size_t l = 0; l < group; ++l)
+                kernel.tap_major[(((g * size) + t) * group) + l] = kernel.weights[(((g * group) + l) * size) + t];
+}
+
 template<typename T>
 T weighted_avg(const std::vector<T>& samples, const Kernel<T>& kernel, intmax_t index)
 {
@@ -172,6 +231,7 @@ template<typename T>
 std::vector<T>& apply_filter(const std::vector<T>& samples, const Kernel<T>& kernel, std::vector<T>& output)
 {
     const auto sz = samples.size();
+    assert(output.size() >= sz); // callers presize the output, this must not allocate per frame
     if(output.size() < sz)
         output.resize(sz);
     for(auto i = 0u; i < sz; ++i)
@@ -184,6 +244,7 @@ std::vector<T>& apply_interp_filter(const T *samples, size_t sz, const std::vect
 {
     const auto xsz = (intmax_t)x.size();
     const auto d = (intmax_t)kernel.radius * 2;
+    assert((intmax_t)output.size() >= xsz);
     if((intmax_t)output.size() < xsz)
         output.resize(xsz);
     for(intmax_t i = 0, j = 0; i < xsz; ++i, j += d)
@@ -197,6 +258,7 @@ std::vector<T>& apply_interp_filter(const T *samples, size_t sz, const std::vect
 {
     const auto d = (intmax_t)kernel.radius * 2;
     const auto bands = (intmax_t)band_widths.size();
+    assert((intmax_t)output.size() >= bands);
     if((intmax_t)output.size() < bands)
         output.resize(bands);
     for(intmax_t i = 0, k = 0, l = 0; i < bands; ++i)
@@ -210,10 +272,88 @@ std::vector<T>& apply_interp_filter(const T *samples, size_t sz, const std::vect
     return output;
 }
 
+// FIR decimation, only every 'factor'th output of the filter is computed
+// samples must hold ((count - 1) * factor) + kernel.size values
+template<typename T>
+void decimate(const T *samples, size_t count, size_t factor, const Kernel<T>& kernel, T *output)
+{
+    for(size_t i = 0; i < count; ++i)
+    {
+        auto src = &samples[i * factor];
+        auto sum = (T)0;
+        for(auto j = 0; j < kernel.size; ++j)
+            sum += src[j] * kernel.weights[j];
+        output[i] = sum;
+    }
+}
+
+// weighted sum of several sample streams in one pass, output[i] = sum(inputs[j][i] * gains[j])
+template<typename T>
+void mix(const T *const *inputs, const T *gains, size_t num_inputs, size_t count, T *output)
+{
+    for(size_t i = 0; i < count; ++i)
+    {
+        auto sum = (T)0;
+        for(size_t j = 0; j < num_inputs; ++j)
+            sum += inputs[j][i] * gains[j];
+        output[i] = sum;
+    }
+}
+
+// cosine-sum window applied to an unwindowed spectrum, a (2 * radius + 1)-tap convolution
+// 'spectrum' holds the 'bins' interleaved complex values of a real FFT (size 2 * (bins - 1)),
+// bins below 0 and above Nyquist are the conjugates of their mirror images
+// taps[0] is the center tap, taps[m] applies to both bins at distance m, output[i] is bin first + i
+template<typename T>
+void spectral_window(const T *spectrum, size_t bins, const T *taps, int radius, size_t first, size_t count, T *output)
+{
+    const auto last = (intmax_t)bins - 1;
+    for(size_t i = 0; i < count; ++i)
+    {
+        const auto k = (intmax_t)(first + i);
+        auto re = spectrum[k * 2] * taps[0];
+        auto im = spectrum[(k * 2) + 1] * taps[0];
+        for(auto m = 1; m <= radius; ++m)
+        {
+            for(auto b : { k - m, k + m })
+            {
+                auto conj = (b < 0) || (b > last);
+                if(b < 0)
+                    b = -b;
+                else if(b > last)
+                    b = (last * 2) - b;
+                re += spectrum[b * 2] * taps[m];
+                im += (conj ? -spectrum[(b * 2) + 1] : spectrum[(b * 2) + 1]) * taps[m];
+            }
+        }
+        output[i * 2] = re;
+        output[(i * 2) + 1] = im;
+    }
+}
+
 #ifdef ENABLE_X86_SIMD
 
+// candidate implementations of weighted_avg(), chosen per kernel size (see calibration.hpp)
+enum class FilterVariant : uint8_t
+{
+    SCALAR,
+    SSE,
+    AVX
+};
+
+void decimate_fma3(const float *samples, size_t count, size_t factor, const Kernel<float>& kernel, float *output);
+
+void mix_fma3(const float *const *inputs, const float *gains, size_t num_inputs, size_t count, float *output);
+
+void spectral_window_fma3(const float *spectrum, size_t bins, const float *taps, int radius, size_t first, size_t count, float *output);
+
 float weighted_avg_fma3(const std::vector<float>& samples, const Kernel<float>& kernel, intmax_t index);
 
+float weighted_avg_fma3_256(const std::vector<float>& samples, const Kernel<float>& kernel, intmax_t index);
+
+std::vector<float>& apply_filter_fma3(const std::vector<float>& samples, const Kernel<float>& kernel, std::vector<float>& output, FilterVariant variant);
+
+// uses the calibrated variant for this kernel size
 std::vector<float>& apply_filter_fma3(const std::vector<float>& samples, const Kernel<float>& kernel, std::vector<float>& output);
 
 std::vector<float>& apply_interp_filter_fma3(const float *samples, size_t sz, const std::vector<float>& x, const Kernel<float>& kernel, std::vector<float>& output);
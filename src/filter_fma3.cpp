@@ -17,13 +17,15 @@
 
 #include "filter.hpp"
 #include "simd_helpers.hpp"
+#include "calibration.hpp"
 #include <immintrin.h>
 #include <cassert>
+#include <algorithm>
 
 float weighted_avg_fma3(const std::vector<float>& samples, const Kernel<float>& kernel, intmax_t index)
 {
-    // NOTE: Initial tests with 'usuable' radius values seemed to reveal performance benefit for 128-bit vectors
-    // averaging 2-3 iterations vs 1 iteration of 256-bit, but this could use re-tesing and can definitely be done better in any case.
+    // NOTE: 128-bit vectors used to be faster than 256-bit for 'usable' radius values on older hardware,
+    // apply_filter_fma3() now picks between this and weighted_avg_fma3_256() per CPU (see calibration.hpp).
     const auto start = (index - kernel.radius) + 1;
     const auto stop = index + kernel.radius;
     float sum = 0.0f;
@@ -55,48 +57,130 @@ float weighted_avg_fma3(const std::vector<float>& samples, const Kernel<float>&
     }
 }
 
-std::vector<float>& apply_filter_fma3(const std::vector<float>& samples, const Kernel<float>& kernel, std::vector<float>& output)
+// same as weighted_avg_fma3() with 256-bit vectors
+float weighted_avg_fma3_256(const std::vector<float>& samples, const Kernel<float>& kernel, intmax_t index)
+{
+    const auto start = (index - kernel.radius) + 1;
+    const auto stop = index + kernel.radius;
+    if((start < 0) || (stop > (intmax_t)samples.size()))
+        return weighted_avg(samples, kernel, index);
+
+    constexpr auto step = sizeof(__m256) / sizeof(float);
+    const auto avxstop = start + kernel.avx_size;
+    auto vecsum = _mm256_setzero_ps();
+    auto i = start;
+    for(; i < avxstop; i += step)
+        vecsum = _mm256_fmadd_ps(_mm256_loadu_ps(&samples[i]), _mm256_load_ps(&kernel.weights[i - start]), vecsum);
+    auto sum = horizontal_sum(vecsum);
+    for(; i < stop; ++i)
+        sum += samples[i] * kernel.weights[i - start];
+    return sum / kernel.sum;
+}
+
+std::vector<float>& apply_filter_fma3(const std::vector<float>& samples, const Kernel<float>& kernel, std::vector<float>& output, FilterVariant variant)
 {
     const auto sz = samples.size();
+    assert(output.size() >= sz);
     if(output.size() < sz)
         output.resize(sz);
-    if((size_t)kernel.sse_size >= ((sizeof(__m128) / sizeof(float)) * 2)) // make sure we get at least 2 SIMD iterations
+    switch(variant)
     {
+    case FilterVariant::AVX:
+        for(auto i = 0u; i < sz; ++i)
+            output[i] = weighted_avg_fma3_256(samples, kernel, i);
+        break;
+
+    case FilterVariant::SSE:
         for(auto i = 0u; i < sz; ++i)
             output[i] = weighted_avg_fma3(samples, kernel, i);
-    }
-    else // otherwise use the plain C version
-    {
+        break;
+
+    case FilterVariant::SCALAR:
+    default:
         for(auto i = 0u; i < sz; ++i)
             output[i] = weighted_avg(samples, kernel, i);
+        break;
     }
     return output;
 }
 
+std::vector<float>& apply_filter_fma3(const std::vector<float>& samples, const Kernel<float>& kernel, std::vector<float>& output)
+{
+    return apply_filter_fma3(samples, kernel, output, calibration::filter_variant(kernel));
+}
+
+// one output point of a kernel.size = 8 filter, 'weights' points at the point's 8 taps
+static WAV_FORCE_INLINE float interp_point_x8(const float *samples, size_t sz, intmax_t index, const float *weights)
+{
+    if((index >= 3) && (index < (intmax_t)sz - 4))
+        return horizontal_sum(_mm256_mul_ps(_mm256_loadu_ps(&samples[index - 3]), _mm256_load_ps(weights)));
+
+    const auto start = index - 3;
+    const auto stop = std::min(index + 5, (intmax_t)sz);
+    auto sum = _mm_setzero_ps();
+    for(auto k = std::max(start, (intmax_t)0); k < stop; ++k)
+        sum = _mm_fmadd_ss(_mm_load_ss(&samples[k]), _mm_load_ss(&weights[k - start]), sum);
+    return _mm_cvtss_f32(sum);
+}
+
 // specialized for kernel.size = 8
 static std::vector<float>& apply_interp_filter_fma3_x8(const float *samples, size_t sz, const std::vector<float>& x, const Kernel<float>& kernel, std::vector<float>& output)
 {
     assert(kernel.radius == 4);
     constexpr auto step = sizeof(__m256) / sizeof(float);
-    const auto avx_stop = (intmax_t)sz - 4;
     const auto xsz = x.size();
+    assert(output.size() >= xsz);
     if(output.size() < xsz)
         output.resize(xsz);
     for(size_t i = 0, j = 0; i < xsz; ++i, j += step)
+        output[i] = interp_point_x8(samples, sz, (intmax_t)x[i], &kernel.weights[j]);
+    return output;
+}
+
+// specialized for kernel.size = 8 with tap-major weights
+// 8 points at a time, each tap is one vertical FMA across the 8 points (no horizontal sums)
+// x must be non-decreasing so a group is in range if its first and last points are
+static std::vector<float>& apply_interp_filter_fma3_x8_t(const float *samples, size_t sz, const std::vector<float>& x, const Kernel<float>& kernel, std::vector<float>& output)
+{
+    assert(kernel.radius == 4);
+    constexpr auto step = sizeof(__m256) / sizeof(float);
+    const auto avx_stop = (intmax_t)sz - 4;
+    const auto xsz = x.size();
+    const auto groups_end = xsz & -step;
+    assert(output.size() >= xsz);
+    if(output.size() < xsz)
+        output.resize(xsz);
+
+    // prologue, groups reaching past the start of the input
+    size_t i = 0;
+    for(; (i < groups_end) && ((intmax_t)x[i] < 3); i += step)
+        for(size_t l = 0; l < step; ++l)
+            output[i + l] = interp_point_x8(samples, sz, (intmax_t)x[i + l], &kernel.weights[(i + l) * step]);
+
+    for(; (i < groups_end) && ((intmax_t)x[i + step - 1] < avx_stop); i += step)
     {
-        auto index = (intmax_t)x[i];
-        if((index >= 3) && (index < avx_stop))
-            output[i] = horizontal_sum(_mm256_mul_ps(_mm256_loadu_ps(&samples[index - 3]), _mm256_load_ps(&kernel.weights[j])));
-        else
+        // points l and l + 4 share a register, the in-lane transposes then yield one tap of all 8 points per register
+        __m256 taps[step];
+        for(size_t l = 0; l < 4; ++l)
         {
-            const auto start = index - 3;
-            const auto stop = std::min(index + 5, (intmax_t)sz);
-            auto sum = _mm_setzero_ps();
-            for(auto k = std::max(start, (intmax_t)0); k < stop; ++k)
-                sum = _mm_fmadd_ss(_mm_load_ss(&samples[k]), _mm_load_ss(&kernel.weights[j + (k - start)]), sum);
-            output[i] = _mm_cvtss_f32(sum);
+            auto lo = &samples[(intmax_t)x[i + l] - 3];
+            auto hi = &samples[(intmax_t)x[i + l + 4] - 3];
+            taps[l] = loadu2_ps(lo, hi);
+            taps[l + 4] = loadu2_ps(lo + 4, hi + 4);
         }
+        transpose4x4_lanes(&taps[0]);
+        transpose4x4_lanes(&taps[4]);
+
+        const auto weights = &kernel.tap_major[i * step];
+        auto sum = _mm256_mul_ps(taps[0], _mm256_load_ps(weights));
+        for(size_t t = 1; t < step; ++t)
+            sum = _mm256_fmadd_ps(taps[t], _mm256_load_ps(&weights[t * step]), sum);
+        _mm256_storeu_ps(&output[i], sum);
     }
+
+    // epilogue, groups reaching past the end of the input and the trailing partial group
+    for(; i < xsz; ++i)
+        output[i] = interp_point_x8(samples, sz, (intmax_t)x[i], &kernel.weights[i * step]);
     return output;
 }
 
@@ -108,6 +192,7 @@ static std::vector<float>& apply_interp_filter_fma3_x8(const float *samples, siz
     constexpr auto step = sizeof(__m256) / sizeof(float);
     const auto avx_stop = (intmax_t)sz - 4;
     const auto bands = (intmax_t)band_widths.size();
+    assert((intmax_t)output.size() >= bands);
     if((intmax_t)output.size() < bands)
         output.resize(bands);
     for(intmax_t i = 0, k = 0, l = 0; i < bands; ++i)
@@ -136,30 +221,68 @@ static std::vector<float>& apply_interp_filter_fma3_x8(const float *samples, siz
     return output;
 }
 
+// one output point of a kernel.size = 4 filter, 'weights' points at the point's 4 taps
+static WAV_FORCE_INLINE float interp_point_x4(const float *samples, size_t sz, intmax_t index, const float *weights)
+{
+    if((index >= 1) && (index < (intmax_t)sz - 2))
+        return horizontal_sum(_mm_mul_ps(_mm_loadu_ps(&samples[index - 1]), _mm_load_ps(weights)));
+
+    const auto start = index - 1;
+    const auto stop = std::min(index + 3, (intmax_t)sz);
+    auto sum = _mm_setzero_ps();
+    for(auto k = std::max(start, (intmax_t)0); k < stop; ++k)
+        sum = _mm_fmadd_ss(_mm_load_ss(&samples[k]), _mm_load_ss(&weights[k - start]), sum);
+    return _mm_cvtss_f32(sum);
+}
+
 // specialized for kernel.size = 4
 static std::vector<float>& apply_interp_filter_fma3_x4(const float *samples, size_t sz, const std::vector<float>& x, const Kernel<float>& kernel, std::vector<float>& output)
 {
     assert(kernel.radius == 2);
     constexpr auto step = sizeof(__m128) / sizeof(float);
-    const auto sse_stop = (intmax_t)sz - 2;
     const auto xsz = x.size();
+    assert(output.size() >= xsz);
     if(output.size() < xsz)
         output.resize(xsz);
     for(size_t i = 0, j = 0; i < xsz; ++i, j += step)
+        output[i] = interp_point_x4(samples, sz, (intmax_t)x[i], &kernel.weights[j]);
+    return output;
+}
+
+// specialized for kernel.size = 4 with tap-major weights, see apply_interp_filter_fma3_x8_t()
+static std::vector<float>& apply_interp_filter_fma3_x4_t(const float *samples, size_t sz, const std::vector<float>& x, const Kernel<float>& kernel, std::vector<float>& output)
+{
+    assert(kernel.radius == 2);
+    constexpr auto step = sizeof(__m256) / sizeof(float);
+    constexpr auto taps = sizeof(__m128) / sizeof(float);
+    const auto sse_stop = (intmax_t)sz - 2;
+    const auto xsz = x.size();
+    const auto groups_end = xsz & -step;
+    assert(output.size() >= xsz);
+    if(output.size() < xsz)
+        output.resize(xsz);
+
+    size_t i = 0;
+    for(; (i < groups_end) && ((intmax_t)x[i] < 1); i += step)
+        for(size_t l = 0; l < step; ++l)
+            output[i + l] = interp_point_x4(samples, sz, (intmax_t)x[i + l], &kernel.weights[(i + l) * taps]);
+
+    for(; (i < groups_end) && ((intmax_t)x[i + step - 1] < sse_stop); i += step)
     {
-        auto index = (intmax_t)x[i];
-        if((index >= 1) && (index < sse_stop))
-            output[i] = horizontal_sum(_mm_mul_ps(_mm_loadu_ps(&samples[index - 1]), _mm_load_ps(&kernel.weights[j])));
-        else
-        {
-            const auto start = index - 1;
-            const auto stop = std::min(index + 3, (intmax_t)sz);
-            auto sum = _mm_setzero_ps();
-            for(auto k = std::max(start, (intmax_t)0); k < stop; ++k)
-                sum = _mm_fmadd_ss(_mm_load_ss(&samples[k]), _mm_load_ss(&kernel.weights[j + (k - start)]), sum);
-            output[i] = _mm_cvtss_f32(sum);
-        }
+        __m256 cols[taps];
+        for(size_t l = 0; l < taps; ++l)
+            cols[l] = loadu2_ps(&samples[(intmax_t)x[i + l] - 1], &samples[(intmax_t)x[i + l + 4] - 1]);
+        transpose4x4_lanes(cols);
+
+        const auto weights = &kernel.tap_major[i * taps];
+        auto sum = _mm256_mul_ps(cols[0], _mm256_load_ps(weights));
+        for(size_t t = 1; t < taps; ++t)
+            sum = _mm256_fmadd_ps(cols[t], _mm256_load_ps(&weights[t * step]), sum);
+        _mm256_storeu_ps(&output[i], sum);
     }
+
+    for(; i < xsz; ++i)
+        output[i] = interp_point_x4(samples, sz, (intmax_t)x[i], &kernel.weights[i * taps]);
     return output;
 }
 
@@ -171,6 +294,7 @@ static std::vector<float>& apply_interp_filter_fma3_x4(const float *samples, siz
     constexpr auto step = sizeof(__m128) / sizeof(float);
     const auto sse_stop = (intmax_t)sz - 2;
     const auto bands = (intmax_t)band_widths.size();
+    assert((intmax_t)output.size() >= bands);
     if((intmax_t)output.size() < bands)
         output.resize(bands);
     for(intmax_t i = 0, k = 0, l = 0; i < bands; ++i)
@@ -200,7 +324,11 @@ static std::vector<float>& apply_interp_filter_fma3_x4(const float *samples, siz
 
 std::vector<float>& apply_interp_filter_fma3(const float *samples, size_t sz, const std::vector<float>& x, const Kernel<float>& kernel, std::vector<float>& output)
 {
-    if(kernel.size == 8)
+    if(kernel.tap_major && (kernel.size == 8))
+        return apply_interp_filter_fma3_x8_t(samples, sz, x, kernel, output);
+    else if(kernel.tap_major && (kernel.size == 4))
+        return apply_interp_filter_fma3_x4_t(samples, sz, x, kernel, output);
+    else if(kernel.size == 8)
         return apply_interp_filter_fma3_x8(samples, sz, x, kernel, output); // lanczos
     else if(kernel.size == 4)
         return apply_interp_filter_fma3_x4(samples, sz, x, kernel, output); // catmull-rom
@@ -217,3 +345,64 @@ std::vector<float>& apply_interp_filter_fma3(const float *samples, size_t sz, co
     else
         return apply_interp_filter(samples, sz, band_widths, x, kernel, output); // fallback
 }
+
+void decimate_fma3(const float *samples, size_t count, size_t factor, const Kernel<float>& kernel, float *output)
+{
+    constexpr auto step = sizeof(__m256) / sizeof(float);
+    assert(kernel.avx_size == kernel.size); // lowpass kernels are zero padded to a multiple of 8
+    for(size_t i = 0; i < count; ++i)
+    {
+        auto src = &samples[i * factor];
+        auto sum = _mm256_setzero_ps();
+        for(auto j = 0; j < kernel.avx_size; j += step)
+            sum = _mm256_fmadd_ps(_mm256_loadu_ps(&src[j]), _mm256_load_ps(&kernel.weights[j]), sum);
+        output[i] = horizontal_sum(sum);
+    }
+}
+
+void mix_fma3(const float *const *inputs, const float *gains, size_t num_inputs, size_t count, float *output)
+{
+    constexpr auto step = sizeof(__m256) / sizeof(float);
+    const auto max = count & -step;
+    for(size_t i = 0; i < max; i += step)
+    {
+        auto sum = _mm256_setzero_ps();
+        for(size_t j = 0; j < num_inputs; ++j)
+            sum = _mm256_fmadd_ps(_mm256_loadu_ps(&inputs[j][i]), _mm256_set1_ps(gains[j]), sum);
+        _mm256_storeu_ps(&output[i], sum);
+    }
+    for(auto i = max; i < count; ++i)
+    {
+        auto sum = 0.0f;
+        for(size_t j = 0; j < num_inputs; ++j)
+            sum += inputs[j][i] * gains[j];
+        output[i] = sum;
+    }
+}
+
+void spectral_window_fma3(const float *spectrum, size_t bins, const float *taps, int radius, size_t first, size_t count, float *output)
+{
+    // the taps are real so the interleaved data can be convolved as plain floats, 4 bins per vector
+    // bins whose neighbourhood crosses 0 or Nyquist go through the generic version
+    constexpr auto step = sizeof(__m256) / sizeof(float) / 2;
+    const auto end = first + count;
+    const auto lo = std::clamp(first, (size_t)radius, end);
+    const auto hi = std::max(std::min(end, bins - radius), lo);
+    const auto vec_end = lo + ((hi - lo) & -step);
+    spectral_window(spectrum, bins, taps, radius, first, lo - first, output);
+
+    assert(radius <= 3);
+    __m256 vtaps[4];
+    for(auto m = 0; m <= radius; ++m)
+        vtaps[m] = _mm256_set1_ps(taps[m]);
+    for(auto k = lo; k < vec_end; k += step)
+    {
+        auto src = &spectrum[k * 2];
+        auto sum = _mm256_mul_ps(_mm256_loadu_ps(src), vtaps[0]);
+        for(auto m = 1; m <= radius; ++m)
+            sum = _mm256_fmadd_ps(_mm256_add_ps(_mm256_loadu_ps(src - (m * 2)), _mm256_loadu_ps(src + (m * 2))), vtaps[m], sum);
+        _mm256_storeu_ps(&output[(k - first) * 2], sum);
+    }
+
+    spectral_window(spectrum, bins, taps, radius, vec_end, end - vec_end, &output[(vec_end - first) * 2]);
+}
@@ -0,0 +1,195 @@
+/*
+    Copyright (C) 2024 Devin Davila
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "filterbank.hpp"
+#include <algorithm>
+#include <complex>
+#include <cmath>
+#include <numbers>
+#include <cstring>
+
+void FilterBank::init(int fraction, float low, float high, uint32_t sample_rate, size_t channels, bool fma3)
+{
+    m_fma3 = fma3;
+    m_channels = std::min(channels, MAX_CHANNELS);
+    m_centers.clear();
+
+    // midband frequencies are 1 kHz * G^(x/b) for odd b and G^((2x+1)/2b) for even b, G = 10^(3/10)
+    constexpr auto pi = std::numbers::pi;
+    const auto b = (double)std::max(fraction, 1);
+    const auto G = std::pow(10.0, 0.3);
+    const auto half_band = std::pow(G, 1.0 / (2.0 * b)); // ratio of the band edges to the midband frequency
+    const auto fs = (double)std::max(sample_rate, 1u);
+    const auto limit = (fs * 0.45) / half_band;
+    auto midband = [&](int x) {
+        return (fraction & 1) ? 1000.0 * std::pow(G, x / b) : 1000.0 * std::pow(G, ((2.0 * x) + 1.0) / (2.0 * b));
+    };
+    const auto lo = std::min(std::max((double)low, 1.0), limit);
+    auto x = (int)std::floor((b * std::log(lo / 1000.0)) / std::log(G)) - 1;
+    while(midband(x) < lo)
+        ++x;
+    if(midband(x) > limit)
+        --x;
+    for(; (midband(x) <= high) && (midband(x) <= limit); ++x)
+        m_centers.push_back((float)midband(x));
+    if(m_centers.empty())
+        m_centers.push_back((float)midband(x));
+
+    const auto bands = m_centers.size();
+    m_groups = (bands + LANES - 1) / LANES;
+    m_coeffs.reset(m_groups * COEFF_STRIDE);
+    m_gain.reset(m_groups * LANES);
+    m_state.reset(m_groups * STATE_STRIDE * m_channels);
+
+    // padding lanes have g = 0 and never leave zero
+    for(size_t i = 0; i < m_groups * COEFF_STRIDE; ++i)
+        m_coeffs[i] = 0.0f;
+    for(size_t i = 0; i < m_groups * LANES; ++i)
+        m_gain[i] = 0.0f;
+
+    // 3rd order Butterworth lowpass prototype, the real pole and the upper one of the complex pair
+    const std::complex<double> protos[] = { { -1.0, 0.0 }, { -0.5, std::sqrt(3.0) / 2.0 } };
+    for(size_t i = 0; i < bands; ++i)
+    {
+        // band edges prewarped for the bilinear transform, g = tan(pi * f / fs) is the frequency in that domain
+        const auto fm = (double)m_centers[i];
+        const auto w1 = std::tan((pi * (fm / half_band)) / fs);
+        const auto w2 = std::tan((pi * (fm * half_band)) / fs);
+        const auto w0 = std::sqrt(w1 * w2);
+        const auto bw = w2 - w1;
+
+        // lowpass to bandpass: each prototype pole p gives the roots of s^2 - p * bw * s + w0^2
+        // the real pole makes one section, the complex pair makes two
+        std::complex<double> poles[SECTIONS];
+        auto count = 0u;
+        for(const auto& p : protos)
+        {
+            const auto d = std::sqrt((p * p * bw * bw) - (4.0 * w0 * w0));
+            const auto r1 = ((p * bw) + d) * 0.5;
+            const auto r2 = ((p * bw) - d) * 0.5;
+            if(p.imag() == 0.0)
+                poles[count++] = (r1.imag() >= 0.0) ? r1 : r2;
+            else
+            {
+                poles[count++] = (r1.imag() >= 0.0) ? r1 : std::conj(r1);
+                poles[count++] = (r2.imag() >= 0.0) ? r2 : std::conj(r2);
+            }
+        }
+
+        // state variable sections (band output g*s / (s^2 + g*k*s + g^2)), gain normalized at the band center
+        const auto group = i / LANES;
+        const auto lane = i % LANES;
+        auto c = &m_coeffs[group * COEFF_STRIDE];
+        auto response = 1.0;
+        for(size_t s = 0; s < SECTIONS; ++s)
+        {
+            const auto g = std::abs(poles[s]);
+            const auto k = (-2.0 * poles[s].real()) / g;
+            const auto a1 = 1.0 / (1.0 + (g * (g + k)));
+            c[(((s * 3) + 0) * LANES) + lane] = (float)a1;
+            c[(((s * 3) + 1) * LANES) + lane] = (float)(g * a1);
+            c[(((s * 3) + 2) * LANES) + lane] = (float)(g * g * a1);
+            const std::complex<double> jw(0.0, w0);
+            response *= std::abs((g * jw) / ((jw * jw) + (g * k * jw) + (g * g)));
+        }
+        m_gain[i] = (float)(2.0 / (response * response));
+
+        // mean square time constant of about two periods of the bandwidth
+        const auto tau = std::clamp(2.0 / ((fm * half_band) - (fm / half_band)), 0.005, 0.2);
+        c[(SECTIONS * 3 * LANES) + lane] = (float)(1.0 - std::exp(-1.0 / (tau * fs)));
+    }
+
+    reset();
+}
+
+void FilterBank::reset()
+{
+    for(size_t i = 0; i < m_channels; ++i)
+        reset(i);
+}
+
+void FilterBank::reset(size_t channel)
+{
+    if((channel >= m_channels) || (m_state == nullptr))
+        return;
+    auto state = &m_state[channel * m_groups * STATE_STRIDE];
+    std::fill(state, state + (m_groups * STATE_STRIDE), 0.0f);
+}
+
+void FilterBank::process(size_t channel, const float *samples, size_t count)
+{
+    if((channel >= m_channels) || (m_groups == 0))
+        return;
+    auto state = &m_state[channel * m_groups * STATE_STRIDE];
+#ifdef ENABLE_X86_SIMD
+    if(m_fma3)
+        filterbank_process_fma3(m_coeffs.get(), state, m_groups, samples, count);
+    else
+        filterbank_process(m_coeffs.get(), state, m_groups, samples, count);
+#else
+    filterbank_process(m_coeffs.get(), state, m_groups, samples, count);
+#endif
+}
+
+void FilterBank::levels(size_t channel, float *out) const
+{
+    if(channel >= m_channels)
+        return;
+    for(size_t i = 0; i < m_centers.size(); ++i)
+    {
+        const auto ms = m_state[(((channel * m_groups) + (i / LANES)) * STATE_STRIDE) + (SECTIONS * 2 * LANES) + (i % LANES)];
+        out[i] = std::sqrt(std::max(ms, 0.0f) * m_gain[i]);
+    }
+}
+
+// one group of bands at a time over the whole block, the samples stay in L1 between groups
+void filterbank_process(const float *coeffs, float *state, size_t groups, const float *samples, size_t count)
+{
+    constexpr auto L = FilterBank::LANES;
+    constexpr auto S = FilterBank::SECTIONS;
+    for(size_t group = 0; group < groups; ++group)
+    {
+        const auto c = &coeffs[group * FilterBank::COEFF_STRIDE];
+        auto st = &state[group * FilterBank::STATE_STRIDE];
+        const auto env = &c[S * 3 * L];
+        auto ms = &st[S * 2 * L];
+        for(size_t n = 0; n < count; ++n)
+        {
+            float v[L];
+            std::fill(v, v + L, samples[n]);
+            for(size_t s = 0; s < S; ++s)
+            {
+                const auto a1 = &c[s * 3 * L];
+                const auto a2 = a1 + L;
+                const auto a3 = a2 + L;
+                auto ic1 = &st[s * 2 * L];
+                auto ic2 = ic1 + L;
+                for(size_t l = 0; l < L; ++l)
+                {
+                    const auto v3 = v[l] - ic2[l];
+                    const auto v1 = (a1[l] * ic1[l]) + (a2[l] * v3);
+                    const auto v2 = ic2[l] + (a2[l] * ic1[l]) + (a3[l] * v3);
+                    ic1[l] = (2.0f * v1) - ic1[l];
+                    ic2[l] = (2.0f * v2) - ic2[l];
+                    v[l] = v1;
+                }
+            }
+            for(size_t l = 0; l < L; ++l)
+                ms[l] += env[l] * ((v[l] * v[l]) - ms[l]);
+        }
+    }
+}
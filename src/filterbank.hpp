@@ -0,0 +1,66 @@
+/*
+    Copyright (C) 2024 Devin Davila
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include "aligned_buffer.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Fractional-octave band analysis, an alternative to the FFT for bar displays.
+// Every band is a 6th order Butterworth bandpass around a base-ten midband frequency (IEC 61260)
+// built from three cascaded state variable filter sections, followed by a mean square envelope.
+// Bands are stored as groups of 8 lanes so a group is one AVX vector, every sample goes through
+// the filters once as it arrives, there is no window to fill.
+class FilterBank
+{
+public:
+    static constexpr size_t MAX_CHANNELS = 2;
+    static constexpr size_t SECTIONS = 3;
+    static constexpr size_t LANES = 8;
+    static constexpr size_t COEFF_STRIDE = ((SECTIONS * 3) + 1) * LANES;   // per group: a1, a2, a3 for each section, envelope coefficient
+    static constexpr size_t STATE_STRIDE = ((SECTIONS * 2) + 1) * LANES;   // per group and channel: ic1, ic2 for each section, mean square
+
+    // 'fraction' bands per octave with midband frequencies between 'low' and 'high'
+    // (at least one band, the upper band edge stays below 0.45 * sample_rate)
+    void init(int fraction, float low, float high, uint32_t sample_rate, size_t channels, bool fma3);
+    void reset();                   // clear filter state and envelopes
+    void reset(size_t channel);
+
+    size_t bands() const noexcept { return m_centers.size(); }
+    const std::vector<float>& centers() const noexcept { return m_centers; }
+
+    void process(size_t channel, const float *samples, size_t count);
+
+    // amplitude of the sine with each band's mean square, a full scale tone reads 1.0 like the FFT magnitudes
+    void levels(size_t channel, float *out) const;
+
+private:
+    size_t m_groups = 0;
+    size_t m_channels = 0;
+    bool m_fma3 = false;
+    std::vector<float> m_centers;
+    AlignedBuffer<float> m_coeffs;
+    AlignedBuffer<float> m_gain;    // per band, 2 * (cascade normalization)^2 applied to the mean square
+    AlignedBuffer<float> m_state;
+};
+
+void filterbank_process(const float *coeffs, float *state, size_t groups, const float *samples, size_t count);
+
+#ifdef ENABLE_X86_SIMD
+void filterbank_process_fma3(const float *coeffs, float *state, size_t groups, const float *samples, size_t count);
+#endif // ENABLE_X86_SIMD
@@ -0,0 +1,65 @@
+/*
+    Copyright (C) 2024 Devin Davila
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "filterbank.hpp"
+#include <immintrin.h>
+
+// same as filterbank_process() with the 8 lanes of a group in one vector, only needs AVX + FMA3
+void filterbank_process_fma3(const float *coeffs, float *state, size_t groups, const float *samples, size_t count)
+{
+    constexpr auto L = FilterBank::LANES;
+    constexpr auto S = FilterBank::SECTIONS;
+    const auto two = _mm256_set1_ps(2.0f);
+    for(size_t group = 0; group < groups; ++group)
+    {
+        const auto c = &coeffs[group * FilterBank::COEFF_STRIDE];
+        auto st = &state[group * FilterBank::STATE_STRIDE];
+        __m256 a1[S], a2[S], a3[S], ic1[S], ic2[S];
+        for(size_t s = 0; s < S; ++s)
+        {
+            a1[s] = _mm256_load_ps(&c[((s * 3) + 0) * L]);
+            a2[s] = _mm256_load_ps(&c[((s * 3) + 1) * L]);
+            a3[s] = _mm256_load_ps(&c[((s * 3) + 2) * L]);
+            ic1[s] = _mm256_load_ps(&st[((s * 2) + 0) * L]);
+            ic2[s] = _mm256_load_ps(&st[((s * 2) + 1) * L]);
+        }
+        const auto env = _mm256_load_ps(&c[S * 3 * L]);
+        auto ms = _mm256_load_ps(&st[S * 2 * L]);
+
+        for(size_t n = 0; n < count; ++n)
+        {
+            auto v = _mm256_broadcast_ss(&samples[n]);
+            for(size_t s = 0; s < S; ++s)
+            {
+                const auto v3 = _mm256_sub_ps(v, ic2[s]);
+                const auto v1 = _mm256_fmadd_ps(a2[s], v3, _mm256_mul_ps(a1[s], ic1[s]));
+                const auto v2 = _mm256_fmadd_ps(a3[s], v3, _mm256_fmadd_ps(a2[s], ic1[s], ic2[s]));
+                ic1[s] = _mm256_fmsub_ps(two, v1, ic1[s]);
+                ic2[s] = _mm256_fmsub_ps(two, v2, ic2[s]);
+                v = v1;
+            }
+            ms = _mm256_fmadd_ps(env, _mm256_fmsub_ps(v, v, ms), ms);
+        }
+
+        for(size_t s = 0; s < S; ++s)
+        {
+            _mm256_store_ps(&st[((s * 2) + 0) * L], ic1[s]);
+            _mm256_store_ps(&st[((s * 2) + 1) * L], ic2[s]);
+        }
+        _mm256_store_ps(&st[S * 2 * L], ms);
+    }
+}
@@ -0,0 +1,66 @@
+/*
+    Copyright (C) 2024 Devin Davila
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <cstdint>
+#include <bit>
+
+// IEEE 754 binary16 conversion, round to nearest even (same results as F16C vcvtps2ph/vcvtph2ps)
+// storage format only, all math is done in float
+
+inline uint16_t float_to_half(float f)
+{
+    auto x = std::bit_cast<uint32_t>(f);
+    const auto sign = (uint16_t)((x >> 16) & 0x8000u);
+    x &= 0x7fffffffu;
+
+    if(x > 0x7f800000u)                 // NaN (quiet)
+        return sign | 0x7e00u | (uint16_t)((x >> 13) & 0x3ffu);
+    if(x >= 0x47800000u)                // >= 65536 and inf, 65520 and up is rounded to inf below
+        return sign | 0x7c00u;
+    if(x < 0x38800000u)                 // below the smallest normal half (2^-14)
+    {
+        if(x <= 0x33000000u)            // <= 2^-25 rounds to zero
+            return sign;
+        const auto shift = 126u - (x >> 23);
+        const auto mant = (x & 0x7fffffu) | 0x800000u;
+        auto h = mant >> shift;
+        const auto rem = mant & ((1u << shift) - 1u);
+        const auto half = 1u << (shift - 1u);
+        h += ((rem > half) || ((rem == half) && (h & 1u))) ? 1u : 0u;
+        return sign | (uint16_t)h;
+    }
+
+    // rebias the exponent, a carry out of the mantissa rolls over into the next exponent (or inf)
+    auto h = (x - 0x38000000u) >> 13;
+    const auto rem = x & 0x1fffu;
+    h += ((rem > 0x1000u) || ((rem == 0x1000u) && (h & 1u))) ? 1u : 0u;
+    return sign | (uint16_t)h;
+}
+
+inline float half_to_float(uint16_t h)
+{
+    const auto sign = (uint32_t)(h & 0x8000u) << 16;
+    const auto exp = (uint32_t)(h >> 10) & 0x1fu;
+    const auto mant = (uint32_t)h & 0x3ffu;
+    if(exp == 0x1fu)                    // inf or NaN (NaNs come back quiet)
+        return std::bit_cast<float>(sign | 0x7f800000u | (mant ? 0x400000u : 0u) | (mant << 13));
+    if(exp != 0)
+        return std::bit_cast<float>(sign | ((exp + 112u) << 23) | (mant << 13));
+    const auto val = (float)mant * 0x1p-24f; // zero or subnormal, exact
+    return sign ? -val : val;
+}
@@ -0,0 +1,51 @@
+/*
+    Copyright (C) 2024 Devin Davila
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "latency.hpp"
+#include <algorithm>
+#include <iterator>
+
+LatencyTracker::Stats LatencyTracker::stats()
+{
+    Stats ret;
+    if(m_count == 0)
+        return ret;
+
+    std::copy_n(m_history, m_count, m_sorted);
+    std::sort(m_sorted, m_sorted + m_count);
+    int64_t sum = 0;
+    for(size_t i = 0; i < m_count; ++i)
+        sum += m_sorted[i];
+
+    auto percentile = [this](size_t p) { return m_sorted[std::min(((m_count * p) + 99) / 100, m_count) - 1]; };
+    ret.count = m_count;
+    ret.min = m_sorted[0];
+    ret.max = m_sorted[m_count - 1];
+    ret.mean = sum / (int64_t)m_count;
+    ret.p50 = percentile(50);
+    ret.p95 = percentile(95);
+    ret.p99 = percentile(99);
+    return ret;
+}
+
+uint32_t LatencyTracker::histogram(uint32_t (&buckets)[BUCKETS]) const
+{
+    std::fill(std::begin(buckets), std::end(buckets), 0u);
+    for(size_t i = 0; i < m_count; ++i)
+        ++buckets[(size_t)std::clamp(m_history[i] / BUCKET_NS, (int64_t)0, (int64_t)BUCKETS - 1)];
+    return *std::max_element(std::begin(buckets), std::end(buckets));
+}
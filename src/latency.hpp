@@ -0,0 +1,64 @@
+/*
+    Copyright (C) 2024 Devin Davila
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Per-frame latency between the newest audio sample an analysis used and the time the result was rendered.
+// Keeps the last HISTORY frames, statistics are computed on demand.
+class LatencyTracker
+{
+public:
+    static constexpr size_t HISTORY = 512;                  // frames (about 8 seconds at 60 FPS)
+    static constexpr size_t BUCKETS = 25;                   // histogram buckets, the last one also counts anything longer
+    static constexpr int64_t BUCKET_NS = 10000000ll;        // 10 ms per bucket
+
+    struct Stats
+    {
+        size_t count = 0;
+        int64_t min = 0;    // nanoseconds
+        int64_t max = 0;
+        int64_t mean = 0;
+        int64_t p50 = 0;
+        int64_t p95 = 0;
+        int64_t p99 = 0;
+    };
+
+    void reset() { *this = {}; }
+
+    void record(int64_t latency)
+    {
+        m_history[m_pos] = latency;
+        m_pos = (m_pos + 1) % HISTORY;
+        if(m_count < HISTORY)
+            ++m_count;
+    }
+
+    size_t count() const { return m_count; }
+
+    Stats stats();
+
+    // frames per bucket, returns the largest bucket
+    uint32_t histogram(uint32_t (&buckets)[BUCKETS]) const;
+
+private:
+    int64_t m_history[HISTORY]{};
+    int64_t m_sorted[HISTORY]{};    // scratch for stats()
+    size_t m_pos = 0;
+    size_t m_count = 0;
+};
@@ -16,25 +16,68 @@
 */
 
 #pragma once
-#include <string>
-#include <sstream>
+#include <string_view>
+#include <algorithm>
+#include <type_traits>
+#include <cstdio>
 #include <obs-module.h>
 #include "module.hpp"
 
+// formats into a fixed stack buffer so logging never touches the heap
+// messages longer than the buffer are truncated
 class Log
 {
 private:
-    std::stringstream m_stream;
+    static constexpr size_t BUFSZ = 512;
+    char m_buf[BUFSZ];
+    size_t m_len = 0;
     int m_loglevel;
 
+    void append(std::string_view str)
+    {
+        auto count = std::min(str.size(), BUFSZ - 1 - m_len);
+        str.copy(&m_buf[m_len], count);
+        m_len += count;
+    }
+
+    template<typename... Args>
+    void append_fmt(const char *fmt, Args... args)
+    {
+        auto ret = snprintf(&m_buf[m_len], BUFSZ - m_len, fmt, args...);
+        if(ret > 0)
+            m_len = std::min(m_len + (size_t)ret, BUFSZ - 1);
+    }
+
 public:
-    Log(int loglevel) : m_loglevel(loglevel) { m_stream << "[" MODULE_NAME "]: "; }
-    ~Log() { blog(m_loglevel, "%s", m_stream.str().c_str()); }
+    Log(int loglevel) : m_loglevel(loglevel) { append("[" MODULE_NAME "]: "); }
+    ~Log()
+    {
+        m_buf[m_len] = '\0';
+        blog(m_loglevel, "%s", m_buf);
+    }
+
+    Log(const Log&) = delete;
+    Log& operator=(const Log&) = delete;
 
     template<typename T>
     Log& operator<<(const T& obj)
     {
-        m_stream << obj;
+        if constexpr(std::is_convertible_v<const T&, std::string_view>)
+            append(obj);
+        else if constexpr(std::is_same_v<T, bool>)
+            append(obj ? "1" : "0");
+        else if constexpr(std::is_same_v<T, char>)
+            append(std::string_view(&obj, 1));
+        else if constexpr(std::is_enum_v<T>)
+            *this << (std::underlying_type_t<T>)obj;
+        else if constexpr(std::is_integral_v<T> && std::is_signed_v<T>)
+            append_fmt("%lld", (long long)obj);
+        else if constexpr(std::is_integral_v<T>)
+            append_fmt("%llu", (unsigned long long)obj);
+        else if constexpr(std::is_floating_point_v<T>)
+            append_fmt("%g", (double)obj);
+        else
+            append_fmt("%p", (const void*)obj);
         return *this;
     }
 };
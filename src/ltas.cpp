@@ -0,0 +1,112 @@
+/*
+    Copyright (C) 2024 Devin Davila
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "ltas.hpp"
+#include <algorithm>
+#include <cmath>
+
+void LtasAccumulator::init(size_t channels, size_t bins, unsigned seconds)
+{
+    reset();
+    if((channels == 0) || (bins == 0) || (seconds == 0))
+        return;
+
+    const auto slots = std::min(seconds, MAX_SLOTS);
+    m_channels = std::min(channels, (size_t)2);
+    m_bins = bins;
+    m_stride = (bins + 7) & ~(size_t)7;
+    m_num_slots = slots + 1;
+    m_slot_ns = ((uint64_t)seconds * 1000000000ull) / slots;
+    for(size_t i = 0; i < m_channels; ++i)
+    {
+        m_slots[i].reset(m_num_slots * m_stride);
+        m_total[i].reset(m_stride);
+    }
+    clear();
+}
+
+void LtasAccumulator::reset()
+{
+    for(auto& i : m_slots)
+        i.reset();
+    for(auto& i : m_total)
+        i.reset();
+    m_channels = 0;
+    m_bins = 0;
+    m_stride = 0;
+    m_num_slots = 0;
+    clear();
+}
+
+void LtasAccumulator::clear()
+{
+    for(size_t i = 0; i < m_channels; ++i)
+    {
+        std::fill(m_slots[i].get(), m_slots[i].get() + (m_num_slots * m_stride), 0.0f);
+        std::fill(m_total[i].get(), m_total[i].get() + m_stride, 0.0);
+    }
+    std::fill(std::begin(m_slot_frames), std::end(m_slot_frames), 0u);
+    m_total_frames = 0;
+    m_slot = 0;
+    m_slot_end = 0;
+}
+
+void LtasAccumulator::advance(uint64_t ts)
+{
+    if(m_channels == 0)
+        return;
+    if((m_slot_end == 0) || (ts < m_slot_end - m_slot_ns) || ((ts >= m_slot_end) && (ts - m_slot_end >= m_slot_ns * m_num_slots)))
+    {
+        // first tick, clock went backwards or everything expired
+        if(m_slot_end != 0)
+            clear();
+        m_slot_end = ts + m_slot_ns;
+        return;
+    }
+
+    while(ts >= m_slot_end)
+    {
+        const auto next = (m_slot + 1) % m_num_slots;
+        for(size_t channel = 0; channel < m_channels; ++channel)
+        {
+            auto total = m_total[channel].get();
+            const auto done = &m_slots[channel][m_slot * m_stride];
+            auto expired = &m_slots[channel][next * m_stride];
+            for(size_t i = 0; i < m_bins; ++i)
+                total[i] += (double)done[i] - (double)expired[i];
+            std::fill(expired, expired + m_stride, 0.0f);
+        }
+        m_total_frames += m_slot_frames[m_slot];
+        m_total_frames -= m_slot_frames[next];
+        m_slot_frames[next] = 0;
+        m_slot = next;
+        m_slot_end += m_slot_ns;
+    }
+}
+
+void LtasAccumulator::mean_db(size_t channel, float *out, float floor) const
+{
+    const auto count = frames();
+    const auto total = m_total[channel].get();
+    const auto partial = &m_slots[channel][m_slot * m_stride];
+    const auto scale = (count > 0) ? 1.0 / (double)count : 0.0;
+    for(size_t i = 0; i < m_bins; ++i)
+    {
+        auto power = (total[i] + (double)partial[i]) * scale;
+        out[i] = (power > 0.0) ? std::max((float)(10.0 * std::log10(power)), floor) : floor;
+    }
+}
@@ -0,0 +1,63 @@
+/*
+    Copyright (C) 2024 Devin Davila
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include "aligned_buffer.hpp"
+#include <cstddef>
+#include <cstdint>
+
+// Long-term average spectrum over a sliding window of 'seconds'.
+// Power is summed into the partial sum of the current slot every tick, when a slot expires
+// its sum is added to the running total and the sum of the slot that falls out of the window
+// is subtracted. The cost per tick is O(bins) regardless of the window length.
+// Windows longer than MAX_SLOTS seconds use slots of several seconds.
+class LtasAccumulator
+{
+public:
+    static constexpr unsigned MAX_SLOTS = 60;
+
+    void init(size_t channels, size_t bins, unsigned seconds);
+    void reset();   // free everything
+    void clear();   // start over
+
+    explicit operator bool() const noexcept { return m_channels > 0; }
+
+    // rotate slots as needed for time 'ts' (nanoseconds), call before adding this tick's power
+    void advance(uint64_t ts);
+
+    // current slot's power sums, add one frame's power per bin then commit()
+    float *partial(size_t channel) { return &m_slots[channel][m_slot * m_stride]; }
+    void commit() { ++m_slot_frames[m_slot]; }
+
+    uint64_t frames() const { return m_total_frames + m_slot_frames[m_slot]; }
+
+    // mean power as dB, 'floor' for bins without energy
+    void mean_db(size_t channel, float *out, float floor) const;
+
+private:
+    size_t m_channels = 0;
+    size_t m_bins = 0;
+    size_t m_stride = 0;                // bins rounded up to a multiple of 8
+    size_t m_num_slots = 0;             // window slots plus the current one
+    size_t m_slot = 0;
+    uint64_t m_slot_ns = 0;
+    uint64_t m_slot_end = 0;            // time the current slot expires, 0 before the first tick
+    AlignedBuffer<float> m_slots[2];    // m_num_slots * m_stride partial sums per channel
+    AlignedBuffer<double> m_total[2];   // sum of all slots but the current one
+    uint32_t m_slot_frames[MAX_SLOTS + 1] = {};
+    uint64_t m_total_frames = 0;
+};
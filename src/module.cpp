@@ -17,6 +17,7 @@
 
 #include "module.hpp"
 #include "source.hpp"
+#include "vbuf_pool.hpp"
 #include <obs-module.h>
 
 OBS_DECLARE_MODULE()
@@ -40,5 +41,7 @@ MODULE_EXPORT bool obs_module_load()
 
 MODULE_EXPORT void obs_module_unload()
 {
-    //...
+    obs_enter_graphics();
+    vbuf_pool::clear();
+    obs_leave_graphics();
 }
@@ -0,0 +1,92 @@
+/*
+    Copyright (C) 2024 Devin Davila
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "onset.hpp"
+#include <algorithm>
+#include <iterator>
+#include <cmath>
+
+void OnsetDetector::reset(float sensitivity)
+{
+    *this = {};
+    m_multiplier = 1.0f + ((1.0f - std::clamp(sensitivity, 0.0f, 1.0f)) * 2.0f);
+}
+
+bool OnsetDetector::process(float flux, uint64_t ts)
+{
+    // adaptive threshold from the mean of the preceding frames
+    const auto mean = (m_history_count > 0) ? m_history_sum / (float)m_history_count : 0.0f;
+    m_threshold = std::max(mean * m_multiplier, MIN_FLUX);
+    m_flux = flux;
+
+    m_history_sum += flux - m_history[m_history_pos];
+    m_history[m_history_pos] = flux;
+    m_history_pos = (m_history_pos + 1) % HISTORY;
+    m_history_count = std::min(m_history_count + 1, HISTORY);
+    if(m_history_pos == 0)
+    {
+        // recompute the sum once per lap so rounding errors don't accumulate
+        m_history_sum = 0.0f;
+        for(auto i : m_history)
+            m_history_sum += i;
+    }
+
+    // rising edge only, with a refractory period
+    const auto above = flux > m_threshold;
+    const auto rising = above && !m_above;
+    m_above = above;
+    if(!rising || ((m_onset_count > 0) && ((ts - last_onset()) < MIN_INTERVAL)))
+        return false;
+
+    update_tempo(ts);
+    m_onsets[m_onset_pos] = ts;
+    m_onset_pos = (m_onset_pos + 1) % MAX_ONSETS;
+    ++m_onset_count;
+    return true;
+}
+
+void OnsetDetector::update_tempo(uint64_t ts)
+{
+    constexpr auto bins = MAX_BPM - MIN_BPM;
+    for(auto& i : m_tempo_hist)
+        i *= 0.9f;
+
+    // every interval to the recent onsets votes for a tempo, folded into range by octaves
+    const auto count = (size_t)std::min(m_onset_count, (uint64_t)MAX_ONSETS);
+    for(size_t i = 1; i <= count; ++i)
+    {
+        auto prev = m_onsets[(m_onset_pos + MAX_ONSETS - i) % MAX_ONSETS];
+        auto interval = ts - prev;
+        if(interval > MAX_INTERVAL)
+            break;
+        auto bpm = 60.0 / ((double)interval / 1000000000.0);
+        while(bpm < MIN_BPM)
+            bpm *= 2.0;
+        while(bpm >= MAX_BPM)
+            bpm *= 0.5;
+        auto bin = std::clamp((int)std::lround(bpm) - MIN_BPM, 0, bins - 1);
+        auto weight = 1.0f / (float)i; // favour adjacent onsets
+        m_tempo_hist[bin] += weight;
+        if(bin > 0)
+            m_tempo_hist[bin - 1] += weight * 0.5f;
+        if(bin < bins - 1)
+            m_tempo_hist[bin + 1] += weight * 0.5f;
+    }
+
+    auto best = std::max_element(std::begin(m_tempo_hist), std::end(m_tempo_hist));
+    m_bpm = (*best >= 2.0f) ? (float)(MIN_BPM + (best - std::begin(m_tempo_hist))) : 0.0f;
+}
@@ -0,0 +1,71 @@
+/*
+    Copyright (C) 2024 Devin Davila
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Onset detection on the half-wave rectified spectral flux computed by tick_spectrum().
+// An onset is reported on the rising edge of the flux crossing an adaptive threshold
+// (a multiple of the recent mean flux), the tempo is estimated from a decaying histogram
+// of inter-onset intervals folded into MIN_BPM..MAX_BPM.
+class OnsetDetector
+{
+public:
+    static constexpr int MIN_BPM = 60;
+    static constexpr int MAX_BPM = 200;
+
+    // sensitivity in [0, 1], higher values report weaker onsets
+    void reset(float sensitivity = 0.5f);
+
+    // flux is the mean positive magnitude change per bin since the last frame
+    // returns true if an onset was detected at time 'ts' (nanoseconds)
+    bool process(float flux, uint64_t ts);
+
+    float flux() const { return m_flux; }
+    float threshold() const { return m_threshold; }
+    float strength() const { return (m_threshold > 0.0f) ? m_flux / m_threshold : 0.0f; }
+    float bpm() const { return m_bpm; }                     // 0 if no stable tempo
+    uint64_t last_onset() const { return m_onsets[(m_onset_pos + MAX_ONSETS - 1) % MAX_ONSETS]; }
+    uint64_t onset_count() const { return m_onset_count; }
+
+private:
+    static constexpr size_t HISTORY = 64;                   // flux values averaged for the threshold (about a second at 60 FPS)
+    static constexpr size_t MAX_ONSETS = 16;                // onsets kept for the tempo estimate
+    static constexpr uint64_t MIN_INTERVAL = 100000000ull;  // minimum time between onsets in nanoseconds (100 ms)
+    static constexpr uint64_t MAX_INTERVAL = 2000000000ull; // intervals longer than this don't contribute to the tempo (2 s)
+    static constexpr float MIN_FLUX = 1e-5f;                // absolute floor of the threshold (about -100 dB per bin)
+
+    void update_tempo(uint64_t ts);
+
+    float m_multiplier = 2.0f;
+    float m_history[HISTORY]{};
+    size_t m_history_pos = 0;
+    size_t m_history_count = 0;
+    float m_history_sum = 0.0f;
+
+    float m_flux = 0.0f;
+    float m_threshold = 0.0f;
+    bool m_above = false;
+
+    uint64_t m_onsets[MAX_ONSETS]{};
+    size_t m_onset_pos = 0;
+    uint64_t m_onset_count = 0;
+
+    float m_tempo_hist[MAX_BPM - MIN_BPM]{};
+    float m_bpm = 0.0f;
+};
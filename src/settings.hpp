@@ -29,6 +29,13 @@ static inline bool p_equ(const char *s1, const char *s2) { return std::strcmp(s1
 #define P_AUDIO_SRC         "audio_source"
 #define P_NONE              "none"
 #define P_OUTPUT_BUS        "output_bus"
+#define P_AUDIO_GAIN        "audio_gain"
+#define P_MIX_SOURCE_1      "mix_source_1"
+#define P_MIX_SOURCE_2      "mix_source_2"
+#define P_MIX_SOURCE_3      "mix_source_3"
+#define P_MIX_GAIN_1        "mix_gain_1"
+#define P_MIX_GAIN_2        "mix_gain_2"
+#define P_MIX_GAIN_3        "mix_gain_3"
 
 #define P_HIDE_SILENT       "hide_on_silent"
 #define P_IGNORE_MUTE       "ignore_mute"
@@ -102,15 +109,29 @@ static inline bool p_equ(const char *s1, const char *s2) { return std::strcmp(s1
 #define P_ROLLOFF_Q         "rolloff_q"
 #define P_ROLLOFF_RATE      "rolloff_rate"
 
+#define P_ONSET_DETECTION   "onset_detection"
+#define P_ONSET_SENSITIVITY "onset_sensitivity"
+
+#define P_LTAS              "ltas"
+#define P_LTAS_DURATION     "ltas_duration"
+#define P_HISTORY           "spectrum_history"
+#define P_HISTORY_MINUTES   "history_minutes"
+#define P_HISTORY_DEPTH     "history_depth"
+#define P_HISTORY_8BIT      "history_8bit"
+#define P_HISTORY_16BIT     "history_16bit"
+#define P_HISTORY_FILE      "history_file"
+
 #define P_GRAVITY           "gravity"
 #define P_TSMOOTHING        "temporal_smoothing"
 #define P_EXPAVG            "exp_moving_avg"
 #define P_TVEXPAVG          "tv_exp_moving_avg"
 #define P_FAST_PEAKS        "fast_peaks"
+#define P_HALF_HISTORY      "half_history"
 
 #define P_COLOR_BASE        "color_base"
 #define P_COLOR_MIDDLE      "color_middle"
 #define P_COLOR_CREST       "color_crest"
+#define P_COLOR_LTAS        "color_ltas"
 #define P_GRAD_RATIO        "grad_ratio"
 #define P_RANGE_MIDDLE      "range_middle"
 #define P_RANGE_CREST       "range_crest"
@@ -122,17 +143,34 @@ static inline bool p_equ(const char *s1, const char *s2) { return std::strcmp(s1
 #define P_LEVEL_METER       "level_meter"
 #define P_STEPPED_METER     "stepped_level_meter"
 #define P_WAVEFORM          "waveform"
+#define P_VECTORSCOPE       "vectorscope"
 
 #define P_RMS_MODE          "rms_mode"
 #define P_METER_BUF         "meter_buf"
+#define P_SCOPE             "oscilloscope"
+#define P_TRIGGER_LEVEL     "trigger_level"
+#define P_TRIGGER_HYSTERESIS "trigger_hysteresis"
+#define P_VECTOR_LINES      "vector_lines"
+#define P_VECTOR_POINTS     "vector_points"
+#define P_METER_BALLISTICS  "meter_ballistics"
+#define P_VU                "vu"
+#define P_PPM_I             "ppm_type_1"
+#define P_PPM_II            "ppm_type_2"
 
 #define P_BAR_WIDTH         "bar_width"
 #define P_BAR_GAP           "bar_gap"
 #define P_STEP_WIDTH        "step_width"
 #define P_STEP_GAP          "step_gap"
 #define P_MIN_BAR_HEIGHT    "min_bar_height"
+#define P_FILTERBANK        "filterbank"
+#define P_OCTAVE_BANDS      "octave_bands"
+#define P_OCTAVE            "octave"
+#define P_THIRD_OCTAVE      "third_octave"
+#define P_SIXTH_OCTAVE      "sixth_octave"
+#define P_TWELFTH_OCTAVE    "twelfth_octave"
 
 #define P_AUDIO_SYNC_OFFSET "audio_sync_offset"
+#define P_LATENCY_OVERLAY   "latency_overlay"
 
 // tooltip descriptions
 #define P_CHAN_DESC         "chan_desc"
@@ -155,3 +193,13 @@ static inline bool p_equ(const char *s1, const char *s2) { return std::strcmp(s1
 #define P_IGNORE_MUTE_DESC  "ignore_mute_desc"
 #define P_LARGE_FFT_DESC    "large_fft_desc"
 #define P_AUDIO_SYNC_DESC   "audio_sync_desc"
+#define P_MIX_DESC          "mix_desc"
+#define P_ONSET_DESC        "onset_desc"
+#define P_LATENCY_DESC      "latency_desc"
+#define P_BALLISTICS_DESC   "ballistics_desc"
+#define P_LTAS_DESC         "ltas_desc"
+#define P_HALF_HISTORY_DESC "half_history_desc"
+#define P_HISTORY_DESC      "spectrum_history_desc"
+#define P_SCOPE_DESC        "oscilloscope_desc"
+#define P_VECTORSCOPE_DESC  "vectorscope_desc"
+#define P_FILTERBANK_DESC   "filterbank_desc"
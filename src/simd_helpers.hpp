@@ -50,4 +50,24 @@ static WAV_FORCE_INLINE float horizontal_max(__m256 vec)
     return horizontal_max(_mm_max_ps(_mm256_extractf128_ps(vec, 1), _mm256_castps256_ps128(vec)));
 }
 
+// two unaligned 4-float loads into the low and high lanes
+static WAV_FORCE_INLINE __m256 loadu2_ps(const float *lo, const float *hi)
+{
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(lo)), _mm_loadu_ps(hi), 1);
+}
+
+// 4x4 transpose within each 128-bit lane, rows[i][j] becomes rows[j][i]
+// the lane crossing part of a larger transpose is cheaper done while loading (see loadu2_ps())
+static WAV_FORCE_INLINE void transpose4x4_lanes(__m256 rows[4])
+{
+    auto t0 = _mm256_unpacklo_ps(rows[0], rows[1]);
+    auto t1 = _mm256_unpackhi_ps(rows[0], rows[1]);
+    auto t2 = _mm256_unpacklo_ps(rows[2], rows[3]);
+    auto t3 = _mm256_unpackhi_ps(rows[2], rows[3]);
+    rows[0] = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+    rows[1] = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+    rows[2] = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+    rows[3] = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+}
+
 #endif // __AVX__
@@ -0,0 +1,57 @@
+/*
+    Copyright (C) 2024 Devin Davila
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <memory>
+#include <atomic>
+
+// RCU-style publication of immutable data.
+// The writer builds a new object and swaps it in, readers take a reference to whatever is current
+// and keep using it for as long as they need, the last reference frees the old version.
+template<typename T>
+class Snapshot
+{
+public:
+    Snapshot() = default;
+    Snapshot(const Snapshot&) = delete;
+    Snapshot& operator=(const Snapshot&) = delete;
+
+    std::shared_ptr<const T> load() const
+    {
+#ifdef __cpp_lib_atomic_shared_ptr
+        return m_ptr.load(std::memory_order_acquire);
+#else
+        return std::atomic_load_explicit(&m_ptr, std::memory_order_acquire);
+#endif
+    }
+
+    void store(std::shared_ptr<const T> ptr)
+    {
+#ifdef __cpp_lib_atomic_shared_ptr
+        m_ptr.store(std::move(ptr), std::memory_order_release);
+#else
+        std::atomic_store_explicit(&m_ptr, std::move(ptr), std::memory_order_release);
+#endif
+    }
+
+private:
+#ifdef __cpp_lib_atomic_shared_ptr
+    std::atomic<std::shared_ptr<const T>> m_ptr;
+#else
+    std::shared_ptr<const T> m_ptr; // only accessed through the std::atomic_* overloads
+#endif
+};
@@ -18,6 +18,8 @@
 #include "waveform_config.hpp"
 #include "math_funcs.hpp"
 #include "source.hpp"
+#include "calibration.hpp"
+#include "vbuf_pool.hpp"
 #include "settings.hpp"
 #include "log.hpp"
 #include <vector>
@@ -25,6 +27,7 @@
 #include <algorithm>
 #include <limits>
 #include <cassert>
+#include <cstring>
 #include <numbers>
 #include <util/platform.h>
 #include <utility>
@@ -37,6 +40,7 @@ static const auto CPU_INFO = cpu_features::GetX86Info();
 const bool WAVSource::HAVE_AVX2 = CPU_INFO.features.avx2 && CPU_INFO.features.fma3;
 const bool WAVSource::HAVE_AVX = CPU_INFO.features.avx && CPU_INFO.features.fma3;
 const bool WAVSource::HAVE_FMA3 = CPU_INFO.features.fma3;
+const bool WAVSource::HAVE_F16C = CPU_INFO.features.f16c;
 
 #endif // ENABLE_X86_SIMD
 
@@ -46,6 +50,11 @@ const float WAVSource::DB_MIN = 20.0f * std::log10(std::numeric_limits<float>::m
 #define obs_properties_add_color_alpha obs_properties_add_color
 #endif
 
+// property names of the additional mix inputs
+static const char *const MIX_SOURCE_PROPS[] = { P_MIX_SOURCE_1, P_MIX_SOURCE_2, P_MIX_SOURCE_3 };
+static const char *const MIX_GAIN_PROPS[] = { P_MIX_GAIN_1, P_MIX_GAIN_2, P_MIX_GAIN_3 };
+static_assert(std::size(MIX_SOURCE_PROPS) == WAVSource::MAX_MIX_INPUTS - 1);
+
 static bool enum_callback(void *data, obs_source_t *src)
 {
     if(obs_source_get_output_flags(src) & OBS_SOURCE_AUDIO) // filter sources without audio
@@ -119,6 +128,12 @@ namespace callbacks {
     static void get_defaults(obs_data_t *settings)
     {
         obs_data_set_default_string(settings, P_AUDIO_SRC, P_NONE);
+        obs_data_set_default_double(settings, P_AUDIO_GAIN, 0.0);
+        for(auto i = 0; i < WAVSource::MAX_MIX_INPUTS - 1; ++i)
+        {
+            obs_data_set_default_string(settings, MIX_SOURCE_PROPS[i], P_NONE);
+            obs_data_set_default_double(settings, MIX_GAIN_PROPS[i], 0.0);
+        }
         obs_data_set_default_string(settings, P_DISPLAY_MODE, P_CURVE);
         obs_data_set_default_int(settings, P_WIDTH, 800);
         obs_data_set_default_int(settings, P_HEIGHT, 225);
@@ -144,6 +159,7 @@ namespace callbacks {
         obs_data_set_default_string(settings, P_TSMOOTHING, P_EXPAVG);
         obs_data_set_default_double(settings, P_GRAVITY, 0.65);
         obs_data_set_default_bool(settings, P_FAST_PEAKS, false);
+        obs_data_set_default_bool(settings, P_HALF_HISTORY, false);
         obs_data_set_default_int(settings, P_CUTOFF_LOW, 30);
         obs_data_set_default_int(settings, P_CUTOFF_HIGH, 17500);
         obs_data_set_default_int(settings, P_FLOOR, -65);
@@ -151,6 +167,15 @@ namespace callbacks {
         obs_data_set_default_double(settings, P_SLOPE, 0.0);
         obs_data_set_default_double(settings, P_ROLLOFF_Q, 0.0);
         obs_data_set_default_double(settings, P_ROLLOFF_RATE, 0.0);
+        obs_data_set_default_bool(settings, P_ONSET_DETECTION, false);
+        obs_data_set_default_double(settings, P_ONSET_SENSITIVITY, 50.0);
+        obs_data_set_default_bool(settings, P_LTAS, false);
+        obs_data_set_default_int(settings, P_LTAS_DURATION, 30);
+        obs_data_set_default_bool(settings, P_HISTORY, false);
+        obs_data_set_default_int(settings, P_HISTORY_MINUTES, 10);
+        obs_data_set_default_string(settings, P_HISTORY_DEPTH, P_HISTORY_8BIT);
+        obs_data_set_default_string(settings, P_HISTORY_FILE, "");
+        obs_data_set_default_int(settings, P_COLOR_LTAS, 0x80ffffff);
         obs_data_set_default_string(settings, P_RENDER_MODE, P_SOLID);
         obs_data_set_default_int(settings, P_COLOR_BASE, 0xffffffff);
         obs_data_set_default_int(settings, P_COLOR_MIDDLE, 0xffffffff);
@@ -163,14 +188,23 @@ namespace callbacks {
         obs_data_set_default_int(settings, P_STEP_WIDTH, 8);
         obs_data_set_default_int(settings, P_STEP_GAP, 4);
         obs_data_set_default_int(settings, P_MIN_BAR_HEIGHT, 0);
+        obs_data_set_default_bool(settings, P_FILTERBANK, false);
+        obs_data_set_default_string(settings, P_OCTAVE_BANDS, P_THIRD_OCTAVE);
         obs_data_set_default_int(settings, P_METER_BUF, 150);
+        obs_data_set_default_bool(settings, P_SCOPE, false);
+        obs_data_set_default_double(settings, P_TRIGGER_LEVEL, 0.0);
+        obs_data_set_default_double(settings, P_TRIGGER_HYSTERESIS, 2.0);
+        obs_data_set_default_bool(settings, P_VECTOR_LINES, false);
+        obs_data_set_default_int(settings, P_VECTOR_POINTS, 8192);
         obs_data_set_default_bool(settings, P_RMS_MODE, true);
+        obs_data_set_default_string(settings, P_METER_BALLISTICS, P_NONE);
         obs_data_set_default_bool(settings, P_HIDE_SILENT, false);
         obs_data_set_default_bool(settings, P_IGNORE_MUTE, false);
         obs_data_set_default_bool(settings, P_NORMALIZE_VOLUME, false);
         obs_data_set_default_int(settings, P_VOLUME_TARGET, -8);
         obs_data_set_default_int(settings, P_MAX_GAIN, 30);
         obs_data_set_default_int(settings, P_AUDIO_SYNC_OFFSET, 0);
+        obs_data_set_default_bool(settings, P_LATENCY_OVERLAY, false);
     }
 
     static obs_properties_t *get_properties([[maybe_unused]] void *data)
@@ -188,13 +222,30 @@ namespace callbacks {
             return true;
             });
 
-        for(const auto& str : enumerate_audio_sources())
+        const auto sources = enumerate_audio_sources();
+        for(const auto& str : sources)
             obs_property_list_add_string(srclist, str.c_str(), str.c_str());
 
+        // additional sources mixed into the audio source
+        auto gain = obs_properties_add_float_slider(props, P_AUDIO_GAIN, T(P_AUDIO_GAIN), -30.0, 30.0, 0.5);
+        obs_property_float_set_suffix(gain, " dB");
+        for(auto i = 0; i < WAVSource::MAX_MIX_INPUTS - 1; ++i)
+        {
+            auto mixlist = obs_properties_add_list(props, MIX_SOURCE_PROPS[i], T(MIX_SOURCE_PROPS[i]), OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_STRING);
+            obs_property_set_long_description(mixlist, T(P_MIX_DESC));
+            obs_property_list_add_string(mixlist, T(P_NONE), P_NONE);
+            for(const auto& str : sources)
+                obs_property_list_add_string(mixlist, str.c_str(), str.c_str());
+            auto mixgain = obs_properties_add_float_slider(props, MIX_GAIN_PROPS[i], T(MIX_GAIN_PROPS[i]), -30.0, 30.0, 0.5);
+            obs_property_float_set_suffix(mixgain, " dB");
+        }
+
         // audio sync
         auto audio_sync = obs_properties_add_int_slider(props, P_AUDIO_SYNC_OFFSET, T(P_AUDIO_SYNC_OFFSET), -1000, 1000, 10);
         obs_property_int_set_suffix(audio_sync, " ms");
         obs_property_set_long_description(audio_sync, T(P_AUDIO_SYNC_DESC));
+        auto latency = obs_properties_add_bool(props, P_LATENCY_OVERLAY, T(P_LATENCY_OVERLAY));
+        obs_property_set_long_description(latency, T(P_LATENCY_DESC));
 
         // hide on silent audio
         obs_properties_add_bool(props, P_HIDE_SILENT, T(P_HIDE_SILENT));
@@ -225,11 +276,23 @@ namespace callbacks {
         obs_property_list_add_string(displaylist, T(P_LEVEL_METER), P_LEVEL_METER);
         obs_property_list_add_string(displaylist, T(P_STEPPED_METER), P_STEPPED_METER);
         obs_property_list_add_string(displaylist, T(P_WAVEFORM), P_WAVEFORM);
+        obs_property_list_add_string(displaylist, T(P_VECTORSCOPE), P_VECTORSCOPE);
         obs_properties_add_int(props, P_BAR_WIDTH, T(P_BAR_WIDTH), 1, 256, 1);
         obs_properties_add_int(props, P_BAR_GAP, T(P_BAR_GAP), 0, 256, 1);
         obs_properties_add_int(props, P_STEP_WIDTH, T(P_STEP_WIDTH), 1, 256, 1);
         obs_properties_add_int(props, P_STEP_GAP, T(P_STEP_GAP), 0, 256, 1);
         obs_properties_add_int(props, P_MIN_BAR_HEIGHT, T(P_MIN_BAR_HEIGHT), 0, 1080, 1);
+        auto filterbank = obs_properties_add_bool(props, P_FILTERBANK, T(P_FILTERBANK));
+        obs_property_set_long_description(filterbank, T(P_FILTERBANK_DESC));
+        auto bandlist = obs_properties_add_list(props, P_OCTAVE_BANDS, T(P_OCTAVE_BANDS), OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_STRING);
+        obs_property_list_add_string(bandlist, T(P_OCTAVE), P_OCTAVE);
+        obs_property_list_add_string(bandlist, T(P_THIRD_OCTAVE), P_THIRD_OCTAVE);
+        obs_property_list_add_string(bandlist, T(P_SIXTH_OCTAVE), P_SIXTH_OCTAVE);
+        obs_property_list_add_string(bandlist, T(P_TWELFTH_OCTAVE), P_TWELFTH_OCTAVE);
+        obs_property_set_modified_callback(filterbank, [](obs_properties_t *props, [[maybe_unused]] obs_property_t *property, obs_data_t *settings) -> bool {
+            // most of the FFT options depend on it, let the display mode callback sort them out
+            return obs_property_modified(obs_properties_get(props, P_DISPLAY_MODE), settings);
+            });
         obs_property_set_modified_callback(displaylist, [](obs_properties_t *props, [[maybe_unused]] obs_property_t *property, obs_data_t *settings) -> bool {
             auto disp = obs_data_get_string(settings, P_DISPLAY_MODE);
             auto meter = p_equ(disp, P_LEVEL_METER);
@@ -238,46 +301,67 @@ namespace callbacks {
             auto step = p_equ(disp, P_STEP_BARS) || step_meter;
             auto curve = p_equ(disp, P_CURVE);
             auto waveform = p_equ(disp, P_WAVEFORM);
+            auto vector = p_equ(disp, P_VECTORSCOPE);
+            auto spectrum_bars = p_equ(disp, P_BARS) || p_equ(disp, P_STEP_BARS);
+            auto fb = spectrum_bars && obs_data_get_bool(settings, P_FILTERBANK);
             set_prop_visible(props, P_BAR_WIDTH, bar || step);
             set_prop_visible(props, P_BAR_GAP, bar || step);
             set_prop_visible(props, P_STEP_WIDTH, step);
             set_prop_visible(props, P_STEP_GAP, step);
             set_prop_visible(props, P_MIN_BAR_HEIGHT, bar || step);
             set_prop_visible(props, P_CAPS, bar);
+            set_prop_visible(props, P_FILTERBANK, spectrum_bars);
+            set_prop_visible(props, P_OCTAVE_BANDS, fb);
             obs_property_list_item_disable(obs_properties_get(props, P_RENDER_MODE), 0, !curve && !waveform);
             obs_property_list_item_disable(obs_properties_get(props, P_PULSE_MODE), 1, !curve && !p_equ(disp, P_BARS) && !p_equ(disp, P_STEP_BARS));
 
             // meter mode
-            bool notmeter = !(meter || step_meter);
+            bool notmeter = !(meter || step_meter || vector);
             set_prop_visible(props, P_SLOPE, notmeter && !waveform);
             set_prop_visible(props, P_ROLLOFF_Q, notmeter && !waveform);
             set_prop_visible(props, P_ROLLOFF_RATE, notmeter && !waveform);
+            set_prop_visible(props, P_ONSET_DETECTION, notmeter && !waveform && !fb);
+            set_prop_visible(props, P_ONSET_SENSITIVITY, notmeter && !waveform && !fb && obs_data_get_bool(settings, P_ONSET_DETECTION));
+            set_prop_visible(props, P_LTAS, curve);
+            set_prop_visible(props, P_LTAS_DURATION, curve && obs_data_get_bool(settings, P_LTAS));
+            set_prop_visible(props, P_COLOR_LTAS, curve && obs_data_get_bool(settings, P_LTAS));
+            set_prop_visible(props, P_HISTORY, notmeter && !waveform && !fb);
+            set_prop_visible(props, P_HISTORY_MINUTES, notmeter && !waveform && !fb && obs_data_get_bool(settings, P_HISTORY));
+            set_prop_visible(props, P_HISTORY_DEPTH, notmeter && !waveform && !fb && obs_data_get_bool(settings, P_HISTORY));
+            set_prop_visible(props, P_HISTORY_FILE, notmeter && !waveform && !fb && obs_data_get_bool(settings, P_HISTORY));
             set_prop_visible(props, P_CUTOFF_LOW, notmeter && !waveform);
             set_prop_visible(props, P_CUTOFF_HIGH, notmeter && !waveform);
             set_prop_visible(props, P_FILTER_MODE, notmeter);
             set_prop_visible(props, P_FILTER_RADIUS, notmeter && !p_equ(obs_data_get_string(settings, P_FILTER_MODE), P_NONE));
-            set_prop_visible(props, P_INTERP_MODE, notmeter);
+            set_prop_visible(props, P_INTERP_MODE, notmeter && !fb);
             set_prop_visible(props, P_CHANNEL_MODE, notmeter);
             set_prop_visible(props, P_CHANNEL, notmeter && p_equ(obs_data_get_string(settings, P_CHANNEL_MODE), P_SINGLE));
             set_prop_visible(props, P_CHANNEL_SPACING, notmeter && p_equ(obs_data_get_string(settings, P_CHANNEL_MODE), P_STEREO));
-            set_prop_visible(props, P_WINDOW, notmeter && !waveform);
-            set_prop_visible(props, P_SINE_EXPONENT, notmeter && !waveform && p_equ(obs_data_get_string(settings, P_WINDOW), P_POWER_OF_SINE));
-            set_prop_visible(props, P_TSMOOTHING, !waveform);
-            set_prop_visible(props, P_GRAVITY, !waveform && !p_equ(obs_data_get_string(settings, P_TSMOOTHING), P_NONE));
-            set_prop_visible(props, P_FAST_PEAKS, !waveform && !p_equ(obs_data_get_string(settings, P_TSMOOTHING), P_NONE));
+            set_prop_visible(props, P_WINDOW, notmeter && !waveform && !fb);
+            set_prop_visible(props, P_SINE_EXPONENT, notmeter && !waveform && !fb && p_equ(obs_data_get_string(settings, P_WINDOW), P_POWER_OF_SINE));
+            set_prop_visible(props, P_TSMOOTHING, !waveform && !vector);
+            set_prop_visible(props, P_GRAVITY, !waveform && !vector && !p_equ(obs_data_get_string(settings, P_TSMOOTHING), P_NONE));
+            set_prop_visible(props, P_FAST_PEAKS, !waveform && !vector && !p_equ(obs_data_get_string(settings, P_TSMOOTHING), P_NONE));
+            set_prop_visible(props, P_HALF_HISTORY, notmeter && !waveform && !fb && !p_equ(obs_data_get_string(settings, P_TSMOOTHING), P_NONE));
             set_prop_visible(props, P_RADIAL, notmeter);
             set_prop_visible(props, P_DEADZONE, notmeter && obs_data_get_bool(settings, P_RADIAL));
             set_prop_visible(props, P_RADIAL_ARC, notmeter && obs_data_get_bool(settings, P_RADIAL));
             set_prop_visible(props, P_RADIAL_ROTATION, notmeter && obs_data_get_bool(settings, P_RADIAL));
             set_prop_visible(props, P_INVERT, notmeter && obs_data_get_bool(settings, P_RADIAL));
-            set_prop_visible(props, P_LOG_SCALE, notmeter && !waveform);
-            set_prop_visible(props, P_MIRROR_FREQ_AXIS, notmeter && !waveform);
-            set_prop_visible(props, P_WIDTH, notmeter);
-            set_prop_visible(props, P_AUTO_FFT_SIZE, notmeter && !waveform);
-            set_prop_visible(props, P_FFT_SIZE, notmeter && !waveform);
-            set_prop_visible(props, P_ENABLE_LARGE_FFT, notmeter && !waveform);
-            set_prop_visible(props, P_RMS_MODE, !notmeter);
+            set_prop_visible(props, P_LOG_SCALE, notmeter && !waveform && !fb);
+            set_prop_visible(props, P_MIRROR_FREQ_AXIS, notmeter && !waveform && !fb);
+            set_prop_visible(props, P_WIDTH, (notmeter || vector) && !fb);
+            set_prop_visible(props, P_AUTO_FFT_SIZE, notmeter && !waveform && !fb);
+            set_prop_visible(props, P_FFT_SIZE, notmeter && !waveform && !fb);
+            set_prop_visible(props, P_ENABLE_LARGE_FFT, notmeter && !waveform && !fb);
+            set_prop_visible(props, P_RMS_MODE, (meter || step_meter) && p_equ(obs_data_get_string(settings, P_METER_BALLISTICS), P_NONE));
+            set_prop_visible(props, P_METER_BALLISTICS, meter || step_meter);
             set_prop_visible(props, P_METER_BUF, !notmeter || waveform);
+            set_prop_visible(props, P_SCOPE, waveform);
+            set_prop_visible(props, P_TRIGGER_LEVEL, waveform && obs_data_get_bool(settings, P_SCOPE));
+            set_prop_visible(props, P_TRIGGER_HYSTERESIS, waveform && obs_data_get_bool(settings, P_SCOPE));
+            set_prop_visible(props, P_VECTOR_LINES, vector);
+            set_prop_visible(props, P_VECTOR_POINTS, vector);
             set_prop_visible(props, P_NORMALIZE_VOLUME, notmeter);
             set_prop_visible(props, P_VOLUME_TARGET, notmeter && obs_data_get_bool(settings, P_NORMALIZE_VOLUME));
             return true;
@@ -322,6 +406,32 @@ namespace callbacks {
         obs_properties_add_bool(props, P_RMS_MODE, T(P_RMS_MODE));
         auto meterbuf = obs_properties_add_int(props, P_METER_BUF, T(P_METER_BUF), 10, 600000, 10);
         obs_property_int_set_suffix(meterbuf, " ms");
+        auto scope = obs_properties_add_bool(props, P_SCOPE, T(P_SCOPE));
+        obs_property_set_long_description(scope, T(P_SCOPE_DESC));
+        auto trigger_level = obs_properties_add_float_slider(props, P_TRIGGER_LEVEL, T(P_TRIGGER_LEVEL), -100.0, 100.0, 0.1);
+        obs_property_float_set_suffix(trigger_level, " %");
+        auto trigger_hysteresis = obs_properties_add_float_slider(props, P_TRIGGER_HYSTERESIS, T(P_TRIGGER_HYSTERESIS), 0.0, 50.0, 0.1);
+        obs_property_float_set_suffix(trigger_hysteresis, " %");
+        obs_property_set_modified_callback(scope, [](obs_properties_t *props, [[maybe_unused]] obs_property_t *property, obs_data_t *settings) -> bool {
+            auto enable = obs_data_get_bool(settings, P_SCOPE) && obs_property_visible(obs_properties_get(props, P_SCOPE));
+            set_prop_visible(props, P_TRIGGER_LEVEL, enable);
+            set_prop_visible(props, P_TRIGGER_HYSTERESIS, enable);
+            return true;
+            });
+        obs_properties_add_bool(props, P_VECTOR_LINES, T(P_VECTOR_LINES));
+        auto vector_points = obs_properties_add_int(props, P_VECTOR_POINTS, T(P_VECTOR_POINTS), 0, 1 << 20, 256);
+        obs_property_set_long_description(vector_points, T(P_VECTORSCOPE_DESC));
+        auto ballistics = obs_properties_add_list(props, P_METER_BALLISTICS, T(P_METER_BALLISTICS), OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_STRING);
+        obs_property_list_add_string(ballistics, T(P_NONE), P_NONE);
+        obs_property_list_add_string(ballistics, T(P_VU), P_VU);
+        obs_property_list_add_string(ballistics, T(P_PPM_I), P_PPM_I);
+        obs_property_list_add_string(ballistics, T(P_PPM_II), P_PPM_II);
+        obs_property_set_long_description(ballistics, T(P_BALLISTICS_DESC));
+        obs_property_set_modified_callback(ballistics, [](obs_properties_t *props, [[maybe_unused]] obs_property_t *property, obs_data_t *settings) -> bool {
+            auto enable = p_equ(obs_data_get_string(settings, P_METER_BALLISTICS), P_NONE) && obs_property_visible(obs_properties_get(props, P_METER_BALLISTICS));
+            set_prop_visible(props, P_RMS_MODE, enable);
+            return true;
+            });
 
         // channels
         auto chanlst = obs_properties_add_list(props, P_CHANNEL_MODE, T(P_CHANNEL_MODE), OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_STRING);
@@ -385,13 +495,17 @@ namespace callbacks {
         obs_property_list_add_string(tsmoothlist, T(P_TVEXPAVG), P_TVEXPAVG);
         auto grav = obs_properties_add_float_slider(props, P_GRAVITY, T(P_GRAVITY), 0.0, 1.0, 0.01);
         auto peaks = obs_properties_add_bool(props, P_FAST_PEAKS, T(P_FAST_PEAKS));
+        auto half = obs_properties_add_bool(props, P_HALF_HISTORY, T(P_HALF_HISTORY));
         obs_property_set_long_description(tsmoothlist, T(P_TEMPORAL_DESC));
         obs_property_set_long_description(grav, T(P_GRAVITY_DESC));
         obs_property_set_long_description(peaks, T(P_FAST_PEAKS_DESC));
+        obs_property_set_long_description(half, T(P_HALF_HISTORY_DESC));
         obs_property_set_modified_callback(tsmoothlist, [](obs_properties_t *props, [[maybe_unused]] obs_property_t *property, obs_data_t *settings) -> bool {
             auto enable = !p_equ(obs_data_get_string(settings, P_TSMOOTHING), P_NONE) && obs_property_visible(obs_properties_get(props, P_TSMOOTHING));
             set_prop_visible(props, P_GRAVITY, enable);
             set_prop_visible(props, P_FAST_PEAKS, enable);
+            auto disp = obs_data_get_string(settings, P_DISPLAY_MODE);
+            set_prop_visible(props, P_HALF_HISTORY, enable && !p_equ(disp, P_WAVEFORM) && !p_equ(disp, P_LEVEL_METER) && !p_equ(disp, P_STEPPED_METER));
             return true;
             });
 
@@ -429,6 +543,41 @@ namespace callbacks {
         obs_property_set_long_description(rolloff_q, T(P_ROLLOFF_Q_DESC));
         auto rolloff_rate = obs_properties_add_float_slider(props, P_ROLLOFF_RATE, T(P_ROLLOFF_RATE), 0.0, 65.0, 0.01);
         obs_property_set_long_description(rolloff_rate, T(P_ROLLOFF_RATE_DESC));
+        auto onset = obs_properties_add_bool(props, P_ONSET_DETECTION, T(P_ONSET_DETECTION));
+        obs_property_set_long_description(onset, T(P_ONSET_DESC));
+        auto onset_sens = obs_properties_add_float_slider(props, P_ONSET_SENSITIVITY, T(P_ONSET_SENSITIVITY), 0.0, 100.0, 1.0);
+        obs_property_float_set_suffix(onset_sens, "%");
+        obs_property_set_modified_callback(onset, [](obs_properties_t *props, [[maybe_unused]] obs_property_t *property, obs_data_t *settings) -> bool {
+            auto enable = obs_data_get_bool(settings, P_ONSET_DETECTION) && obs_property_visible(obs_properties_get(props, P_ONSET_DETECTION));
+            set_prop_visible(props, P_ONSET_SENSITIVITY, enable);
+            return true;
+            });
+        auto ltas = obs_properties_add_bool(props, P_LTAS, T(P_LTAS));
+        obs_property_set_long_description(ltas, T(P_LTAS_DESC));
+        auto ltas_duration = obs_properties_add_int(props, P_LTAS_DURATION, T(P_LTAS_DURATION), 1, 3600, 1);
+        obs_property_int_set_suffix(ltas_duration, " s");
+        obs_properties_add_color_alpha(props, P_COLOR_LTAS, T(P_COLOR_LTAS));
+        obs_property_set_modified_callback(ltas, [](obs_properties_t *props, [[maybe_unused]] obs_property_t *property, obs_data_t *settings) -> bool {
+            auto enable = obs_data_get_bool(settings, P_LTAS) && obs_property_visible(obs_properties_get(props, P_LTAS));
+            set_prop_visible(props, P_LTAS_DURATION, enable);
+            set_prop_visible(props, P_COLOR_LTAS, enable);
+            return true;
+            });
+        auto history = obs_properties_add_bool(props, P_HISTORY, T(P_HISTORY));
+        obs_property_set_long_description(history, T(P_HISTORY_DESC));
+        auto history_minutes = obs_properties_add_int(props, P_HISTORY_MINUTES, T(P_HISTORY_MINUTES), 1, 240, 1);
+        obs_property_int_set_suffix(history_minutes, " min");
+        auto depthlist = obs_properties_add_list(props, P_HISTORY_DEPTH, T(P_HISTORY_DEPTH), OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_STRING);
+        obs_property_list_add_string(depthlist, T(P_HISTORY_8BIT), P_HISTORY_8BIT);
+        obs_property_list_add_string(depthlist, T(P_HISTORY_16BIT), P_HISTORY_16BIT);
+        obs_properties_add_path(props, P_HISTORY_FILE, T(P_HISTORY_FILE), OBS_PATH_FILE_SAVE, "*.wsph", nullptr);
+        obs_property_set_modified_callback(history, [](obs_properties_t *props, [[maybe_unused]] obs_property_t *property, obs_data_t *settings) -> bool {
+            auto enable = obs_data_get_bool(settings, P_HISTORY) && obs_property_visible(obs_properties_get(props, P_HISTORY));
+            set_prop_visible(props, P_HISTORY_MINUTES, enable);
+            set_prop_visible(props, P_HISTORY_DEPTH, enable);
+            set_prop_visible(props, P_HISTORY_FILE, enable);
+            return true;
+            });
         auto renderlist = obs_properties_add_list(props, P_RENDER_MODE, T(P_RENDER_MODE), OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_STRING);
         obs_property_list_add_string(renderlist, T(P_LINE), P_LINE);
         obs_property_list_add_string(renderlist, T(P_SOLID), P_SOLID);
@@ -487,14 +636,47 @@ namespace callbacks {
         static_cast<WAVSource*>(data)->render(effect);
     }
 
-    static void capture_audio(void *data, obs_source_t *source, const audio_data *audio, bool muted)
+    // proc handlers
+    static void capture_mix_input(void *param, [[maybe_unused]] obs_source_t *source, const audio_data *audio, bool muted)
+    {
+        auto input = static_cast<MixInput*>(param);
+        input->owner->capture_mix_input(input, audio, muted, os_gettime_ns());
+    }
+
+    static void capture_output_bus(void *param, [[maybe_unused]] size_t mix_idx, audio_data *data)
+    {
+        auto input = static_cast<MixInput*>(param);
+        input->owner->capture_output_bus(input, data, os_gettime_ns());
+    }
+
+    static void start_capture_log(void *data, calldata_t *cd)
+    {
+        static_cast<WAVSource*>(data)->start_capture_log(calldata_string(cd, "path"));
+    }
+
+    static void stop_capture_log(void *data, [[maybe_unused]] calldata_t *cd)
+    {
+        static_cast<WAVSource*>(data)->stop_capture_log();
+    }
+
+    static void replay_capture_log(void *data, calldata_t *cd)
+    {
+        static_cast<WAVSource*>(data)->replay_capture_log(calldata_string(cd, "path"), calldata_float(cd, "speed"));
+    }
+
+    static void get_onset_info(void *data, calldata_t *cd)
+    {
+        static_cast<WAVSource*>(data)->get_onset_info(cd);
+    }
+
+    static void get_latency_info(void *data, calldata_t *cd)
     {
-        static_cast<WAVSource*>(data)->capture_audio(source, audio, muted);
+        static_cast<WAVSource*>(data)->get_latency_info(cd);
     }
 
-    static void capture_output_bus(void *param, size_t mix_idx, audio_data *data)
+    static void get_correlation(void *data, calldata_t *cd)
     {
-        static_cast<WAVSource*>(param)->capture_output_bus(mix_idx, data);
+        static_cast<WAVSource*>(data)->get_correlation(cd);
     }
 }
 
@@ -522,6 +704,7 @@ void WAVSource::get_settings(obs_data_t *settings)
     auto tsmoothing = obs_data_get_string(settings, P_TSMOOTHING);
     m_gravity = (float)obs_data_get_double(settings, P_GRAVITY);
     m_fast_peaks = obs_data_get_bool(settings, P_FAST_PEAKS);
+    m_half_history = obs_data_get_bool(settings, P_HALF_HISTORY);
     auto interp = obs_data_get_string(settings, P_INTERP_MODE);
     auto filtermode = obs_data_get_string(settings, P_FILTER_MODE);
     m_filter_radius = (float)obs_data_get_double(settings, P_FILTER_RADIUS);
@@ -546,18 +729,37 @@ void WAVSource::get_settings(obs_data_t *settings)
     m_step_width = (int)obs_data_get_int(settings, P_STEP_WIDTH);
     m_step_gap = (int)obs_data_get_int(settings, P_STEP_GAP);
     m_min_bar_height = (int)obs_data_get_int(settings, P_MIN_BAR_HEIGHT);
+    m_filterbank_enabled = obs_data_get_bool(settings, P_FILTERBANK);
+    auto octave_bands = obs_data_get_string(settings, P_OCTAVE_BANDS);
     m_meter_rms = obs_data_get_bool(settings, P_RMS_MODE);
+    auto ballistics = obs_data_get_string(settings, P_METER_BALLISTICS);
+    m_onset_detection = obs_data_get_bool(settings, P_ONSET_DETECTION);
+    m_onset_sensitivity = (float)obs_data_get_double(settings, P_ONSET_SENSITIVITY) / 100.0f;
+    m_ltas_enabled = obs_data_get_bool(settings, P_LTAS);
+    m_ltas_seconds = (unsigned int)obs_data_get_int(settings, P_LTAS_DURATION);
+    auto color_ltas = obs_data_get_int(settings, P_COLOR_LTAS);
+    m_history_enabled = obs_data_get_bool(settings, P_HISTORY);
+    m_history_minutes = (unsigned int)obs_data_get_int(settings, P_HISTORY_MINUTES);
+    m_history_bytes = p_equ(obs_data_get_string(settings, P_HISTORY_DEPTH), P_HISTORY_16BIT) ? 2 : 1;
+    m_history_path = obs_data_get_string(settings, P_HISTORY_FILE);
     m_meter_ms = (int)obs_data_get_int(settings, P_METER_BUF);
+    m_scope = obs_data_get_bool(settings, P_SCOPE);
+    m_trigger_level = (float)obs_data_get_double(settings, P_TRIGGER_LEVEL) / 100.0f;
+    m_trigger_hysteresis = (float)obs_data_get_double(settings, P_TRIGGER_HYSTERESIS) / 100.0f;
+    m_vector_lines = obs_data_get_bool(settings, P_VECTOR_LINES);
+    m_vector_budget = (unsigned int)obs_data_get_int(settings, P_VECTOR_POINTS);
     m_hide_on_silent = obs_data_get_bool(settings, P_HIDE_SILENT);
     m_ignore_mute = obs_data_get_bool(settings, P_IGNORE_MUTE);
     m_normalize_volume = obs_data_get_bool(settings, P_NORMALIZE_VOLUME);
     m_volume_target = (float)obs_data_get_int(settings, P_VOLUME_TARGET);
     m_max_gain = (float)obs_data_get_int(settings, P_MAX_GAIN);
     m_ts_offset = (int64_t)obs_data_get_int(settings, P_AUDIO_SYNC_OFFSET) * 1000000ll;
+    m_latency_overlay = obs_data_get_bool(settings, P_LATENCY_OVERLAY);
 
     m_color_base = { {{(uint8_t)color_base / 255.0f, (uint8_t)(color_base >> 8) / 255.0f, (uint8_t)(color_base >> 16) / 255.0f, (uint8_t)(color_base >> 24) / 255.0f}} };
     m_color_middle = { {{(uint8_t)color_middle / 255.0f, (uint8_t)(color_middle >> 8) / 255.0f, (uint8_t)(color_middle >> 16) / 255.0f, (uint8_t)(color_middle >> 24) / 255.0f}} };
     m_color_crest = { {{(uint8_t)color_crest / 255.0f, (uint8_t)(color_crest >> 8) / 255.0f, (uint8_t)(color_crest >> 16) / 255.0f, (uint8_t)(color_crest >> 24) / 255.0f}} };
+    m_color_ltas = { {{(uint8_t)color_ltas / 255.0f, (uint8_t)(color_ltas >> 8) / 255.0f, (uint8_t)(color_ltas >> 16) / 255.0f, (uint8_t)(color_ltas >> 24) / 255.0f}} };
 
     if(m_fft_size < 128)
         m_fft_size = 128;
@@ -584,6 +786,20 @@ void WAVSource::get_settings(obs_data_t *settings)
     else
         m_audio_source_name.clear();
 
+    // audio inputs
+    m_mix_count = 0;
+    auto add_input = [this](const char *name, float gain) {
+        if((name == nullptr) || p_equ(name, P_NONE))
+            return;
+        auto& input = m_mix_inputs[m_mix_count++];
+        input.owner = this;
+        input.name = name;
+        input.gain = std::pow(10.0f, gain / 20.0f);
+    };
+    add_input(src_name, (float)obs_data_get_double(settings, P_AUDIO_GAIN));
+    for(auto i = 0; i < MAX_MIX_INPUTS - 1; ++i)
+        add_input(obs_data_get_string(settings, MIX_SOURCE_PROPS[i]), (float)obs_data_get_double(settings, MIX_GAIN_PROPS[i]));
+
     if(p_equ(wnd, P_HANN))
         m_window_func = FFTWindow::HANN;
     else if(p_equ(wnd, P_HAMMING))
@@ -609,6 +825,15 @@ void WAVSource::get_settings(obs_data_t *settings)
     else
         m_filter_mode = FilterMode::NONE;
 
+    if(p_equ(ballistics, P_VU))
+        m_ballistics_mode = MeterBallistics::VU;
+    else if(p_equ(ballistics, P_PPM_I))
+        m_ballistics_mode = MeterBallistics::PPM_I;
+    else if(p_equ(ballistics, P_PPM_II))
+        m_ballistics_mode = MeterBallistics::PPM_II;
+    else
+        m_ballistics_mode = MeterBallistics::NONE;
+
     if(p_equ(tsmoothing, P_EXPAVG))
         m_tsmoothing = TSmoothingMode::EXPONENTIAL;
     else if(p_equ(tsmoothing, P_TVEXPAVG))
@@ -627,6 +852,15 @@ void WAVSource::get_settings(obs_data_t *settings)
     else
         m_render_mode = RenderMode::SOLID;
 
+    if(p_equ(octave_bands, P_OCTAVE))
+        m_octave_fraction = 1;
+    else if(p_equ(octave_bands, P_SIXTH_OCTAVE))
+        m_octave_fraction = 6;
+    else if(p_equ(octave_bands, P_TWELFTH_OCTAVE))
+        m_octave_fraction = 12;
+    else
+        m_octave_fraction = 3;
+
     if(p_equ(pulsemode, P_PEAK_FREQ))
         m_pulse_mode = PulseMode::FREQUENCY;
     else
@@ -642,11 +876,15 @@ void WAVSource::get_settings(obs_data_t *settings)
         m_display_mode = DisplayMode::STEPPED_METER;
     else if(p_equ(display, P_WAVEFORM))
         m_display_mode = DisplayMode::WAVEFORM;
+    else if(p_equ(display, P_VECTORSCOPE))
+        m_display_mode = DisplayMode::VECTORSCOPE;
     else
         m_display_mode = DisplayMode::CURVE;
 
     if((m_display_mode != DisplayMode::BAR) && (m_display_mode != DisplayMode::METER))
         m_rounded_caps = false;
+    if((m_display_mode != DisplayMode::BAR) && (m_display_mode != DisplayMode::STEPPED_BAR))
+        m_filterbank_enabled = false;
 
     m_meter_mode = false;
     if((m_display_mode == DisplayMode::METER) || (m_display_mode == DisplayMode::STEPPED_METER))
@@ -654,6 +892,8 @@ void WAVSource::get_settings(obs_data_t *settings)
         m_radial = false;
         m_meter_mode = true;
     }
+    if(m_display_mode == DisplayMode::VECTORSCOPE)
+        m_radial = false;
 
     if(m_radial)
     {
@@ -665,7 +905,7 @@ void WAVSource::get_settings(obs_data_t *settings)
         m_height -= (int)m_deadzone;
     }
 
-    if(!m_meter_mode && p_equ(channel_mode, P_SINGLE))
+    if(!m_meter_mode && (m_display_mode != DisplayMode::VECTORSCOPE) && p_equ(channel_mode, P_SINGLE))
         m_channel_mode = ChannelMode::SINGLE;
     else if(p_equ(channel_mode, P_STEREO))
         m_channel_mode = ChannelMode::STEREO;
@@ -673,116 +913,276 @@ void WAVSource::get_settings(obs_data_t *settings)
         m_channel_mode = ChannelMode::MONO;
 }
 
+// connect to the main output mix in its native format, there is no converter between the mix and the ring
+// the mix is always float planar at the rate and layout from obs_get_audio_info(), if it isn't the audio subsystem was
+// reset since the last update() and the next one will pick up the new settings
+static bool connect_output_bus(const obs_audio_info& audio_info, MixInput& input)
+{
+    if((audio_info.speakers == speaker_layout::SPEAKERS_UNKNOWN) || (input.channels == 0))
+        return false;
+
+    auto audio = obs_get_audio();
+    auto info = audio_output_get_info(audio);
+    if((info->format != audio_format::AUDIO_FORMAT_FLOAT_PLANAR) || (info->samples_per_sec != audio_info.samples_per_sec) || (info->speakers != audio_info.speakers))
+        return false;
+    return audio_output_connect(audio, 0, nullptr, &callbacks::capture_output_bus, &input);
+}
+
 void WAVSource::recapture_audio()
 {
     // release old capture
     release_audio_capture();
 
-    // add new capture
-    auto src_name = m_audio_source_name.c_str();
-    if(p_equ(src_name, P_NONE))
-        return;
-    else if(p_equ(src_name, P_OUTPUT_BUS))
+    // live capture is suspended while replaying a capture log
+    if(m_replay != nullptr)
+        replay_mix_inputs();
+    else
+        capture_mix_inputs();
+}
+
+void WAVSource::release_audio_capture()
+{
+    release_mix_inputs();
+
+    // reset circular buffers
+    for(auto& i : m_capturebufs)
+    {
+        i.end_pos = 0;
+        i.start_pos = 0;
+        i.size = 0;
+    }
+    m_rms_sync_buf.end_pos = 0;
+    m_rms_sync_buf.start_pos = 0;
+    m_rms_sync_buf.size = 0;
+    for(auto& i : m_decimators)
+        i.reset();
+
+    m_capture_ts = 0;
+    m_audio_ts = 0;
+}
+
+bool WAVSource::check_audio_capture(float seconds)
+{
+    // drop inputs whose source no longer exists, the rest of the mix carries on without them
+    auto missing = false;
+    auto captured = false;
+    for(auto i = 0; i < m_mix_count; ++i)
     {
-        if(m_audio_info.speakers != speaker_layout::SPEAKERS_UNKNOWN)
+        auto& input = m_mix_inputs[i];
+        if(input.source != nullptr)
         {
-            auto audio = obs_get_audio();
-            auto info = audio_output_get_info(audio);
-            if((info->format == audio_format::AUDIO_FORMAT_FLOAT_PLANAR) && (info->samples_per_sec == m_audio_info.samples_per_sec) && (info->speakers == m_audio_info.speakers))
+            auto src = obs_weak_source_get_source(input.source);
+            if(src == nullptr)
             {
-                m_output_bus_captured = audio_output_connect(audio, 0, nullptr, &callbacks::capture_output_bus, this);
+                obs_weak_source_release(input.source);
+                input.source = nullptr;
+                input.ring.clear();
             }
             else
-            {
-                audio_convert_info cvt{};
-                cvt.format = audio_format::AUDIO_FORMAT_FLOAT_PLANAR;
-                cvt.samples_per_sec = m_audio_info.samples_per_sec;
-                cvt.speakers = m_audio_info.speakers;
-                m_output_bus_captured = audio_output_connect(audio, 0, &cvt, &callbacks::capture_output_bus, this);
-            }
+                obs_source_release(src);
         }
+        auto valid = (input.source != nullptr) || input.output_bus;
+        missing = missing || !valid;
+        captured = captured || valid;
     }
-    else
+
+    // periodically try to capture missing inputs
+    if(missing)
     {
-        auto asrc = obs_get_source_by_name(src_name);
-        if(asrc != nullptr)
-        {
-            obs_source_add_audio_capture_callback(asrc, &callbacks::capture_audio, this);
-            m_audio_source = obs_source_get_weak_source(asrc);
-            obs_source_release(asrc);
-        }
-        else
+        m_next_retry -= seconds;
+        if(m_next_retry <= 0.0f)
         {
-            if(m_retries++ == 0)
-                LogWarn << "Failed to get audio source: \"" << src_name << "\"";
+            m_next_retry = RETRY_DELAY;
+            capture_mix_inputs();
+            for(auto i = 0; i < m_mix_count; ++i)
+                captured = captured || (m_mix_inputs[i].source != nullptr) || m_mix_inputs[i].output_bus;
         }
     }
+    return captured;
 }
 
-void WAVSource::release_audio_capture()
+void WAVSource::capture_mix_inputs()
 {
-    if(m_audio_source != nullptr)
+    for(auto i = 0; i < m_mix_count; ++i)
     {
-        auto src = obs_weak_source_get_source(m_audio_source);
-        obs_weak_source_release(m_audio_source);
-        m_audio_source = nullptr;
-        if(src != nullptr)
+        auto& input = m_mix_inputs[i];
+        if((input.source != nullptr) || input.output_bus)
+            continue;
+
+        configure_mix_input(input);
+        if(p_equ(input.name.c_str(), P_OUTPUT_BUS))
+            input.output_bus = connect_output_bus(m_audio_info, input);
+        else
         {
-            obs_source_remove_audio_capture_callback(src, &callbacks::capture_audio, this);
-            obs_source_release(src);
+            auto asrc = obs_get_source_by_name(input.name.c_str());
+            if(asrc != nullptr)
+            {
+                obs_source_add_audio_capture_callback(asrc, &callbacks::capture_mix_input, &input);
+                input.source = obs_source_get_weak_source(asrc);
+                obs_source_release(asrc);
+            }
+            else if(m_retries == 0)
+                LogWarn << "Failed to get audio source: \"" << input.name << "\"";
         }
     }
+    ++m_retries;
+}
 
-    if(m_output_bus_captured)
+// set before the callback is connected (or the replay started), update() releases and recaptures every input
+void WAVSource::configure_mix_input(MixInput& input)
+{
+    input.channel_base = (unsigned int)m_channel_base;
+    input.channels = m_capture_channels;
+    input.rate = m_audio_info.samples_per_sec;
+    input.planes = get_audio_channels(m_audio_info.speakers);
+    input.ignore_mute = m_ignore_mute;
+}
+
+// the capture log feeds the inputs through the same rings and entry points as live capture
+void WAVSource::replay_mix_inputs()
+{
+    release_mix_inputs();
+    for(auto i = 0; i < m_mix_count; ++i)
     {
-        m_output_bus_captured = false;
-        audio_output_disconnect(obs_get_audio(), 0, &callbacks::capture_output_bus, this);
+        configure_mix_input(m_mix_inputs[i]);
+        m_mix_inputs[i].replayed = true;
     }
+}
 
-    // reset circular buffers
-    for(auto& i : m_capturebufs)
+void WAVSource::release_mix_inputs()
+{
+    for(auto& input : m_mix_inputs)
     {
-        i.end_pos = 0;
-        i.start_pos = 0;
-        i.size = 0;
-    }
-    m_rms_sync_buf.end_pos = 0;
-    m_rms_sync_buf.start_pos = 0;
-    m_rms_sync_buf.size = 0;
+        if(input.source != nullptr)
+        {
+            auto src = obs_weak_source_get_source(input.source);
+            obs_weak_source_release(input.source);
+            input.source = nullptr;
+            if(src != nullptr)
+            {
+                obs_source_remove_audio_capture_callback(src, &callbacks::capture_mix_input, &input);
+                obs_source_release(src);
+            }
+        }
 
-    m_capture_ts = 0;
-    m_audio_ts = 0;
+        if(input.output_bus)
+        {
+            input.output_bus = false;
+            audio_output_disconnect(obs_get_audio(), 0, &callbacks::capture_output_bus, &input);
+        }
+
+        input.replayed = false;
+
+        input.ring.clear();
+    }
 }
 
-bool WAVSource::check_audio_capture(float seconds)
+void WAVSource::mix_audio()
 {
-    if(m_output_bus_captured)
-        return true;
+    if(m_capture_channels == 0)
+        return;
 
-    // check if the source still exists
-    if(m_audio_source != nullptr)
+    const auto sr = m_audio_info.samples_per_sec;
+    AudioRing::State state[MAX_MIX_INPUTS];
+    uint64_t newest = 0;
+    for(auto i = 0; i < m_mix_count; ++i)
     {
-        auto src = obs_weak_source_get_source(m_audio_source);
-        if(src == nullptr)
-            release_audio_capture();
-        else
-            obs_source_release(src);
+        auto& input = m_mix_inputs[i];
+        if((input.source != nullptr) || input.output_bus || input.replayed)
+        {
+            state[i] = input.ring.state();
+            newest = std::max(newest, state[i].end_ts);
+        }
     }
+    if(newest == 0)
+        return;
+
+    // align the inputs on the span of time they all have data for
+    // inputs that have fallen too far behind (e.g. inactive sources) are left out of the mix
+    MixInput *live[MAX_MIX_INPUTS];
+    uint64_t avail[MAX_MIX_INPUTS];
+    uint64_t first_ts[MAX_MIX_INPUTS];
+    float gains[MAX_MIX_INPUTS];
+    size_t num_live = 0;
+    uint64_t start = 0;
+    uint64_t end = std::numeric_limits<uint64_t>::max();
+    for(auto i = 0; i < m_mix_count; ++i)
+    {
+        auto& input = m_mix_inputs[i];
+        if(state[i].end_ts == 0)
+            continue;
+        if(state[i].end_ts + MIX_MAX_LAG < newest)
+        {
+            input.ring.consume(state[i].available);
+            continue;
+        }
+        auto len = audio_frames_to_ns(sr, state[i].available);
+        live[num_live] = &input;
+        avail[num_live] = state[i].available;
+        first_ts[num_live] = state[i].end_ts - std::min(len, state[i].end_ts);
+        gains[num_live] = input.gain;
+        start = std::max(start, first_ts[num_live]);
+        end = std::min(end, state[i].end_ts);
+        ++num_live;
+    }
+    if(end <= start)
+        return;
 
-    // if we've lost our source, periodically try to recapture it
-    if(m_audio_source == nullptr)
+    // discard anything ahead of the common start
+    auto frames = ns_to_audio_frames(sr, end - start);
+    for(size_t i = 0; i < num_live; ++i)
     {
-        m_next_retry -= seconds;
-        if(m_next_retry <= 0.0f)
+        auto skip = std::min(ns_to_audio_frames(sr, start - first_ts[i]), avail[i]);
+        live[i]->ring.consume(skip);
+        frames = std::min(frames, avail[i] - skip);
+    }
+
+    // drain probes, the capture probes fire per packet in the audio callbacks
+    [[maybe_unused]] const auto mixed = frames;
+    WAV_TRACE2(mix_start, this, mixed);
+    auto ts = start;
+    while(frames > 0)
+    {
+        // limit the block to the contiguous span of every ring
+        const float *planes[2][MAX_MIX_INPUTS];
+        size_t count = (size_t)std::min(frames, (uint64_t)AUDIO_OUTPUT_FRAMES);
+        for(size_t i = 0; i < num_live; ++i)
+            for(auto channel = 0u; channel < m_capture_channels; ++channel)
+                planes[channel][i] = live[i]->ring.peek(channel, count, count);
+
+        audio_data packet{};
+        packet.frames = (uint32_t)count;
+        packet.timestamp = ts;
+        for(auto channel = 0u; channel < m_capture_channels; ++channel)
         {
-            m_next_retry = RETRY_DELAY;
-            recapture_audio();
-            if((m_audio_source != nullptr) || m_output_bus_captured)
-                return true;
+            // a lone input at unity gain is passed straight from the ring
+            if((num_live == 1) && (gains[0] == 1.0f))
+            {
+                packet.data[m_channel_base + channel] = (uint8_t*)planes[channel][0];
+                continue;
+            }
+
+            auto out = m_mix_bufs[channel].get();
+#ifdef ENABLE_X86_SIMD
+            if(HAVE_AVX)
+                mix_fma3(planes[channel], gains, num_live, count, out);
+            else
+                mix(planes[channel], gains, num_live, count, out);
+#else
+            mix(planes[channel], gains, num_live, count, out);
+#endif // ENABLE_X86_SIMD
+            packet.data[m_channel_base + channel] = (uint8_t*)out;
         }
-        return false;
+
+        for(size_t i = 0; i < num_live; ++i)
+            live[i]->ring.consume(count);
+
+        capture_packet(&packet, false);
+
+        ts += audio_frames_to_ns(sr, count);
+        frames -= count;
     }
-    return true;
+    WAV_TRACE2(mix_end, this, mixed);
 }
 
 void WAVSource::free_bufs()
@@ -791,24 +1191,44 @@ void WAVSource::free_bufs()
     {
         m_decibels[i].reset();
         m_tsmooth_buf[i].reset();
+        m_tsmooth_half[i].reset();
+        m_flux_prev[i].reset();
+        m_ltas_db[i].reset();
     }
+    m_ltas.reset();
 
     m_fft_input.reset();
     m_fft_output.reset();
     m_window_coefficients.reset();
+    m_fft_windowed.reset();
+    m_spectral_radius = 0;
     m_slope_modifiers.reset();
     m_input_rms_buf.reset();
     m_rms_temp_buf.reset();
     m_rolloff_modifiers.reset();
+    for(auto& i : m_mix_bufs)
+        i.reset();
+    for(auto& i : m_mix_inputs)
+        i.ring.reset();
 
     m_kernel = {};
     m_interp_kernel = {};
+    for(auto& i : m_curve_lods)
+    {
+        i.indices.clear();
+        i.interp_kernel = {};
+        i.kernel = {};
+    }
+    m_num_lods = 1;
 
     if(m_fft_plan != nullptr)
     {
         fftwf_destroy_plan(m_fft_plan);
         m_fft_plan = nullptr;
     }
+#ifdef ENABLE_X86_SIMD
+    m_rfft.reset();
+#endif
 
     m_fft_size = 0;
 }
@@ -840,11 +1260,10 @@ bool WAVSource::sync_rms_buffer()
     return true;
 }
 
-void WAVSource::init_interp(unsigned int sz)
+void WAVSource::make_interp_indices(unsigned int sz, std::vector<float>& indices, float& lowbin, float& highbin) const
 {
     const auto maxbin = (m_fft_size / 2) - 1;
-    const auto sr = (float)m_audio_info.samples_per_sec;
-    float lowbin, highbin;
+    const auto sr = (float)m_capture_rate;
     if(m_display_mode == DisplayMode::WAVEFORM)
     {
         lowbin = 0.0f;
@@ -856,17 +1275,40 @@ void WAVSource::init_interp(unsigned int sz)
         highbin = std::clamp((float)m_cutoff_high * m_fft_size / sr, 1.0f, (float)maxbin);
     }
 
-    m_interp_indices.resize(sz);
+    indices.resize(sz);
     if(m_log_scale)
     {
         for(auto i = 0u; i < sz; ++i)
-            m_interp_indices[i] = std::clamp(log_interp(lowbin, highbin, (m_mirror_freq_axis ? i * 2.0f : (float)i) / (float)(sz - 1)), lowbin, highbin);
+            indices[i] = std::clamp(log_interp(lowbin, highbin, (m_mirror_freq_axis ? i * 2.0f : (float)i) / (float)(sz - 1)), lowbin, highbin);
     }
     else
     {
         for(auto i = 0u; i < sz; ++i)
-            m_interp_indices[i] = std::clamp(lerp(lowbin, highbin, (m_mirror_freq_axis ? i * 2.0f : (float)i) / (float)(sz - 1)), lowbin, highbin);
+            indices[i] = std::clamp(lerp(lowbin, highbin, (m_mirror_freq_axis ? i * 2.0f : (float)i) / (float)(sz - 1)), lowbin, highbin);
     }
+}
+
+Kernel<float> WAVSource::make_interp_kernel(const std::vector<float>& indices) const
+{
+    Kernel<float> kernel;
+    if(m_interp_mode == InterpMode::LANCZOS)
+        kernel = make_lanczos_kernel(indices, 4);
+    else if(m_interp_mode == InterpMode::CATROM)
+        kernel = make_catrom_kernel(indices, 0.5f);
+
+#ifdef ENABLE_X86_SIMD
+    // curves are interpolated 8 points at a time from tap-major weights
+    if(HAVE_AVX && ((m_display_mode == DisplayMode::CURVE) || (m_display_mode == DisplayMode::WAVEFORM)))
+        make_tap_major(kernel, indices.size());
+#endif // ENABLE_X86_SIMD
+
+    return kernel;
+}
+
+void WAVSource::init_interp(unsigned int sz)
+{
+    float lowbin, highbin;
+    make_interp_indices(sz, m_interp_indices, lowbin, highbin);
 
     // bar bands
     if((m_display_mode == DisplayMode::BAR) || (m_display_mode == DisplayMode::STEPPED_BAR))
@@ -894,27 +1336,63 @@ void WAVSource::init_interp(unsigned int sz)
             m_interp_indices = std::move(samples);
         }
 
-        if(m_interp_mode == InterpMode::LANCZOS)
-            m_interp_kernel = make_lanczos_kernel(m_interp_indices, 4);
-        else if(m_interp_mode == InterpMode::CATROM)
-            m_interp_kernel = make_catrom_kernel(m_interp_indices, 0.5f);
+        m_interp_kernel = make_interp_kernel(m_interp_indices);
+    }
+
+    // restrict post-FFT processing and storage to the bins the interpolation can touch
+    // [lowbin - radius, highbin + radius], rounded out to AVX alignment
+    if((m_display_mode != DisplayMode::WAVEFORM) && !m_interp_indices.empty())
+    {
+        const auto [minidx, maxidx] = std::minmax_element(m_interp_indices.begin(), m_interp_indices.end());
+        const auto radius = (m_interp_mode != InterpMode::POINT) ? (intmax_t)m_interp_kernel.radius : (intmax_t)1;
+        const auto first = std::max((intmax_t)*minidx - radius + 1, (intmax_t)0) & -8;
+        const auto last = (std::min((intmax_t)*maxidx + radius + 1, (intmax_t)m_fft_size / 2) + 7) & -8;
+        m_bin_start = (size_t)first;
+        m_bin_count = (size_t)(last - first);
+        for(auto& i : m_interp_indices)
+            i -= (float)first;
+    }
+}
+
+void WAVSource::init_curve_lods()
+{
+    // each level halves the number of points across the same bin range as level 0
+    // so the level 0 bin span (m_bin_start/m_bin_count) covers them all
+    m_num_lods = 1;
+    for(auto level = 1; level < CURVE_LODS; ++level)
+    {
+        const auto points = ((m_width - 1) >> level) + 1;
+        if(points < MIN_LOD_POINTS)
+            break;
+        auto& lod = m_curve_lods[level];
+        float lowbin, highbin;
+        make_interp_indices(points, lod.indices, lowbin, highbin);
+        if(m_display_mode != DisplayMode::WAVEFORM)
+            for(auto& i : lod.indices)
+                i -= (float)m_bin_start;
+        if(m_interp_mode != InterpMode::POINT)
+            lod.interp_kernel = make_interp_kernel(lod.indices);
+        if(m_filter_mode == FilterMode::GAUSS)
+            lod.kernel = make_gauss_kernel(m_filter_radius / (float)(1 << level));
+        ++m_num_lods;
     }
 }
 
 void WAVSource::init_rolloff()
 {
-    const auto sz = m_fft_size / 2;
-    const auto sr = (float)m_audio_info.samples_per_sec;
+    // per FFT bin, or per band center with the filter bank
+    const auto sz = m_filterbank_enabled ? m_filterbank.bands() : m_fft_size / 2;
+    const auto sr = (float)m_capture_rate;
     const auto coeff = sr / (float)m_fft_size;
     const auto ratio = std::exp2(m_rolloff_q);
     const auto freq_low = (float)m_cutoff_low * ratio;
     const auto freq_high = (float)m_cutoff_high / ratio;
 
-    m_rolloff_modifiers.reset(m_fft_size / 2);
+    m_rolloff_modifiers.reset(sz);
     m_rolloff_modifiers[0] = 0.0f;
-    for(size_t i = 1u; i < sz; ++i)
+    for(size_t i = m_filterbank_enabled ? 0u : 1u; i < sz; ++i)
     {
-        auto freq = i * coeff;
+        auto freq = m_filterbank_enabled ? m_filterbank.centers()[i] : i * coeff;
         auto ratio_low = freq_low / freq;
         auto ratio_high = freq / freq_high;
         auto low_attenuation = (ratio_low > 1.0f) ? (m_rolloff_rate * std::log2(ratio_low)) : 0.0f;
@@ -950,11 +1428,25 @@ WAVSource::WAVSource(obs_source_t *source)
     create_shader();
 
     obs_leave_graphics();
+
+    // headless benchmarks run without a libobs source to register procs and signals on
+    if(m_source == nullptr)
+        return;
+
+    auto ph = obs_source_get_proc_handler(m_source);
+    proc_handler_add(ph, "void start_capture_log(in string path)", &callbacks::start_capture_log, this);
+    proc_handler_add(ph, "void stop_capture_log()", &callbacks::stop_capture_log, this);
+    proc_handler_add(ph, "void replay_capture_log(in string path, in float speed)", &callbacks::replay_capture_log, this);
+    proc_handler_add(ph, "void get_onset_info(out bool enabled, out float flux, out float threshold, out float bpm, out int count, out int last_onset)", &callbacks::get_onset_info, this);
+    proc_handler_add(ph, "void get_latency_info(out int count, out float min, out float mean, out float p50, out float p95, out float p99, out float max)", &callbacks::get_latency_info, this);
+    proc_handler_add(ph, "void get_correlation(out bool enabled, out float correlation)", &callbacks::get_correlation, this);
+
+    auto sh = obs_source_get_signal_handler(m_source);
+    signal_handler_add(sh, "void onset(ptr source, float strength, float bpm)");
 }
 
 WAVSource::~WAVSource()
 {
-    std::lock_guard lock(m_mtx);
     obs_enter_graphics();
 
     free_vbuf();
@@ -972,30 +1464,26 @@ WAVSource::~WAVSource()
 
 unsigned int WAVSource::width()
 {
-    std::lock_guard lock(m_mtx);
-
-    if(m_meter_mode)
-        return (m_bar_width * m_capture_channels) + ((m_capture_channels > 1) ? m_bar_gap : 0);
-    if(m_radial)
-        return (unsigned int)((m_height + m_deadzone) * 2);
-    return m_width;
+    auto shared = m_shared.load();
+    return (shared != nullptr) ? shared->width : 0;
 }
 
 unsigned int WAVSource::height()
 {
-    std::lock_guard lock(m_mtx);
-
-    if(m_radial)
-        return (unsigned int)((m_height + m_deadzone) * 2);
-    return m_height;
+    auto shared = m_shared.load();
+    return (shared != nullptr) ? shared->height : 0;
 }
 
 void WAVSource::create_vbuf() {
     size_t num_verts = 0;
     bool curve = (m_display_mode == DisplayMode::CURVE) || (m_display_mode == DisplayMode::WAVEFORM);
 
-    if(curve)
+    if(m_curve_fill)
+        num_verts = 4;
+    else if(curve)
         num_verts = (size_t)((m_render_mode == RenderMode::LINE) ? m_width : (m_width * 2));
+    else if(m_display_mode == DisplayMode::VECTORSCOPE)
+        num_verts = m_vector_capacity;
     else
     {
         const auto step_stride = m_step_width + m_step_gap;
@@ -1027,30 +1515,39 @@ void WAVSource::create_vbuf() {
     // FIXME: temporary workaround
     if((num_verts > 0) && ((num_verts * sizeof(vec3)) < (1u << 30)))
     {
-        auto vbdata = gs_vbdata_create();
-        vbdata->num = num_verts;
-        vbdata->points = (vec3*)bmalloc(num_verts * sizeof(vec3));
-        vbdata->num_tex = 1;
-        vbdata->tvarray = (gs_tvertarray*)bzalloc(sizeof(gs_tvertarray));
-        vbdata->tvarray->width = 2;
-        vbdata->tvarray->array = bmalloc(2 * num_verts * sizeof(float));
-        m_vbuf = gs_vertexbuffer_create(vbdata, GS_DYNAMIC);
-
-        if(curve) {
-            if(m_render_mode == RenderMode::LINE)
-            {
-                for(auto i = 0u; i < m_width; ++i)
-                    vec3_set(&vbdata->points[i], (float)i, 0, 0);
-            }
-            else
+        if(m_curve_fill)
+        {
+            m_vbuf = vbuf_pool::acquire(num_verts);
+            if(m_vbuf != nullptr)
             {
-                for(auto i = 0u; i < m_width; ++i)
-                {
-                    vec3_set(&vbdata->points[i * 2], (float)i, 0, 0);
-                    vec3_set(&vbdata->points[(i * 2) + 1], (float)i, 0, 0);
-                }
+                auto vbdata = gs_vertexbuffer_get_data(m_vbuf);
+                vec3_set(&vbdata->points[0], 0, 0, 0);
+                vec3_set(&vbdata->points[1], (float)(m_width - 1), 0, 0);
+                vec3_set(&vbdata->points[2], 0, (float)m_height, 0);
+                vec3_set(&vbdata->points[3], (float)(m_width - 1), (float)m_height, 0);
+                gs_vertexbuffer_flush(m_vbuf);
             }
+
+            const auto rows = m_stereo ? 2u : 1u;
+            m_heights = gs_texture_create(m_width, rows, GS_R32F, 1, nullptr, GS_DYNAMIC);
+            for(auto level = 1; level < m_num_lods; ++level)
+                m_curve_lods[level].heights = gs_texture_create((uint32_t)m_curve_lods[level].indices.size(), rows, GS_R32F, 1, nullptr, GS_DYNAMIC);
+        }
+        else if(m_display_mode == DisplayMode::VECTORSCOPE)
+        {
+            m_vbuf = vbuf_pool::acquire(num_verts);
+            m_corr_vbuf = vbuf_pool::acquire(12);
+            if(m_vbuf != nullptr)
+                m_vector_points = gs_vertexbuffer_get_data(m_vbuf)->points;
+        }
+        else if(curve)
+        {
+            m_vbuf = create_curve_vbuf(m_width);
+            for(auto level = 1; level < m_num_lods; ++level)
+                m_curve_lods[level].vbuf = create_curve_vbuf((unsigned int)m_curve_lods[level].indices.size());
         }
+        else
+            m_vbuf = vbuf_pool::acquire(num_verts);
     }
     else
     {
@@ -1060,13 +1557,57 @@ void WAVSource::create_vbuf() {
     obs_leave_graphics();
 }
 
+gs_vertbuffer_t *WAVSource::create_curve_vbuf(unsigned int points)
+{
+    // points spread evenly over [0, m_width - 1]
+    const auto num_verts = (size_t)((m_render_mode == RenderMode::LINE) ? points : (points * 2));
+    const auto step = (points > 1) ? (float)(m_width - 1) / (float)(points - 1) : 0.0f;
+    auto vbuf = vbuf_pool::acquire(num_verts);
+    if(vbuf == nullptr)
+        return nullptr;
+
+    auto vbdata = gs_vertexbuffer_get_data(vbuf);
+    if(m_render_mode == RenderMode::LINE)
+    {
+        for(auto i = 0u; i < points; ++i)
+            vec3_set(&vbdata->points[i], (float)i * step, 0, 0);
+    }
+    else
+    {
+        for(auto i = 0u; i < points; ++i)
+        {
+            vec3_set(&vbdata->points[i * 2], (float)i * step, 0, 0);
+            vec3_set(&vbdata->points[(i * 2) + 1], (float)i * step, 0, 0);
+        }
+    }
+
+    return vbuf;
+}
+
 void WAVSource::free_vbuf()
 {
-    if(m_vbuf != nullptr)
+    vbuf_pool::release(m_vbuf);
+    m_vbuf = nullptr;
+    if(m_heights != nullptr)
     {
-        gs_vertexbuffer_destroy(m_vbuf);
-        m_vbuf = nullptr;
+        gs_texture_destroy(m_heights);
+        m_heights = nullptr;
     }
+    for(auto& i : m_curve_lods)
+    {
+        vbuf_pool::release(i.vbuf);
+        i.vbuf = nullptr;
+        if(i.heights != nullptr)
+        {
+            gs_texture_destroy(i.heights);
+            i.heights = nullptr;
+        }
+    }
+    vbuf_pool::release(m_overlay_vbuf);
+    m_overlay_vbuf = nullptr;
+    vbuf_pool::release(m_corr_vbuf);
+    m_corr_vbuf = nullptr;
+    m_vector_points = nullptr;
 }
 
 void WAVSource::create_shader()
@@ -1089,7 +1630,6 @@ void WAVSource::free_shader()
 
 void WAVSource::update(obs_data_t *settings)
 {
-    std::lock_guard lock(m_mtx);
     constexpr auto pi = std::numbers::pi_v<float>;
 
     release_audio_capture();
@@ -1134,6 +1674,7 @@ void WAVSource::update(obs_data_t *settings)
         m_fft_size = size_t(m_audio_info.samples_per_sec * (m_meter_ms / 1000.0)) & -16;
 
         memset(m_meter_pos, 0, sizeof(m_meter_pos));
+        m_ballistics.init(m_ballistics_mode, m_audio_info.samples_per_sec);
         for(auto& i : m_meter_buf)
             i = DB_MIN;
         for(auto& i : m_meter_val)
@@ -1153,6 +1694,71 @@ void WAVSource::update(obs_data_t *settings)
         m_fft_size = m_width;
         m_waveform_samples = size_t(m_audio_info.samples_per_sec * (m_meter_ms / 1000.0));
         m_waveform_ts = 0;
+
+        if(m_scope)
+        {
+            // raw samples are drawn, full scale spans the graph
+            m_floor = -1;
+            m_ceiling = 1;
+            m_scope_window = std::max(m_waveform_samples, (size_t)2);
+            m_waveform_samples = m_scope_window * 2; // the last trigger is kept for up to a window
+            m_trigger_armed = false;
+            m_scope_scan = 0;
+            m_scope_trigger = 0;
+        }
+    }
+    else if(m_display_mode == DisplayMode::VECTORSCOPE)
+    {
+        // turn off stuff we don't need in this mode
+        m_window_func = FFTWindow::NONE;
+        m_interp_mode = InterpMode::POINT;
+        m_filter_mode = FilterMode::NONE;
+        m_auto_fft_size = false;
+        m_slope = 0.0f;
+        m_stereo = false;
+        m_normalize_volume = false;
+        m_mirror_freq_axis = false;
+        m_log_scale = false;
+
+        // m_fft_size is unused, points go straight from the capture buffers to m_vbuf
+        m_fft_size = 16;
+        m_vector_window = std::max(size_t(m_audio_info.samples_per_sec * (m_meter_ms / 1000.0)), (size_t)16);
+        m_waveform_samples = m_vector_window * 3; // samples leaving the correlation window must still be buffered
+        m_vector_stride = (m_vector_budget > 0) ? ((m_vector_window + m_vector_budget - 1) / m_vector_budget) : 1;
+        m_vector_capacity = (m_vector_window + m_vector_stride - 1) / m_vector_stride;
+        m_vector_head = 0;
+        m_vector_count = 0;
+        m_vector_pos = 0;
+        m_corr_start = 0;
+        m_corr_lr = m_corr_ll = m_corr_rr = 0.0;
+        m_correlation = 0.0f;
+
+        // square plot above the correlation bar, full scale mono reaches the top
+        const auto area = (float)std::max((int)m_height - CORRELATION_HEIGHT - CORRELATION_GAP, 2);
+        m_vector_cx = (float)m_width / 2.0f;
+        m_vector_cy = area / 2.0f;
+        m_vector_scale = std::min((float)m_width, area) / 4.0f;
+    }
+    else if(m_filterbank_enabled)
+    {
+        // bars come straight from the bands, turn off the FFT side of things
+        m_window_func = FFTWindow::NONE;
+        m_interp_mode = InterpMode::POINT;
+        m_auto_fft_size = false;
+        m_mirror_freq_axis = false;
+        m_log_scale = false;
+
+        // repurpose m_fft_size for the capture buffer size, samples are filtered as they arrive
+        m_fft_size = size_t(m_audio_info.samples_per_sec / 10) & -16;
+
+        // no decimation, the bank runs at the output rate
+#ifdef ENABLE_X86_SIMD
+        m_filterbank.init(m_octave_fraction, (float)m_cutoff_low, (float)m_cutoff_high, m_audio_info.samples_per_sec, m_capture_channels, HAVE_AVX);
+#else
+        m_filterbank.init(m_octave_fraction, (float)m_cutoff_low, (float)m_cutoff_high, m_audio_info.samples_per_sec, m_capture_channels, false);
+#endif
+        m_num_bars = (int)m_filterbank.bands();
+        m_width = (unsigned int)std::max((m_num_bars * (m_bar_width + m_bar_gap)) - m_bar_gap, 1);
     }
 
     if(m_normalize_volume)
@@ -1179,33 +1785,95 @@ void WAVSource::update(obs_data_t *settings)
             m_fft_size = 128;
     }
 
+    // decimate ahead of the FFT when the upper cutoff leaves enough headroom
+    // keeps the same frequency resolution with an FFT m_decimation times smaller
+    // the upper cutoff stays within 80% of the new nyquist, where the lowpass (-6 dB at the new nyquist) is still flat
+    m_decimation = 1;
+    if(!m_meter_mode && (m_display_mode != DisplayMode::WAVEFORM) && (m_display_mode != DisplayMode::VECTORSCOPE) && !m_filterbank_enabled)
+    {
+        while(((m_decimation * 2) <= MAX_DECIMATION) && ((m_fft_size / (m_decimation * 2)) >= 128) && (((double)m_cutoff_high * (m_decimation * 2) * 2.5) <= (double)m_audio_info.samples_per_sec))
+            m_decimation *= 2;
+        m_fft_size = (m_fft_size / m_decimation) & -16;
+    }
+    m_capture_rate = m_audio_info.samples_per_sec / m_decimation;
+    for(auto& i : m_decimators)
+#ifdef ENABLE_X86_SIMD
+        i.init(m_decimation, HAVE_AVX);
+#else
+        i.init(m_decimation, false);
+#endif
+    if(m_decimation > 1)
+        m_decimate_buf.reset(Decimator::MAX_BLOCK);
+    else
+        m_decimate_buf.reset();
+
+    // audio inputs, a lone input at unity gain doesn't need a mix buffer
+    for(auto i = 0; i < m_mix_count; ++i)
+        m_mix_inputs[i].ring.init();
+    if((m_mix_count > 1) || ((m_mix_count == 1) && (m_mix_inputs[0].gain != 1.0f)))
+        for(auto& i : m_mix_bufs)
+            i.reset(AUDIO_OUTPUT_FRAMES);
+
     // initialize buffers
-    auto spectrum_mode = !m_meter_mode && (m_display_mode != DisplayMode::WAVEFORM);
+    auto spectrum_mode = !m_meter_mode && (m_display_mode != DisplayMode::WAVEFORM) && (m_display_mode != DisplayMode::VECTORSCOPE) && !m_filterbank_enabled;
     m_output_channels = ((m_capture_channels > 1) || m_stereo) ? 2u : 1u;
-    for(auto i = 0u; i < m_output_channels; ++i)
+    m_bin_start = 0;
+    if(m_filterbank_enabled)
+        m_bin_count = m_filterbank.bands();
+    else
+        m_bin_count = spectrum_mode ? m_fft_size / 2 : m_fft_size; // narrowed by init_interp()
+    m_half_history = m_half_history && spectrum_mode && (m_tsmoothing != TSmoothingMode::NONE);
+#ifdef ENABLE_X86_SIMD
+    if(HAVE_AVX && !HAVE_F16C) // the AVX paths convert with F16C, every FMA3 CPU has it in practice
+        m_half_history = false;
+#endif // ENABLE_X86_SIMD
+    if(spectrum_mode)
     {
-        auto count = spectrum_mode ? m_fft_size / 2 : m_fft_size;
-        m_decibels[i].reset(count);
-        if(spectrum_mode && (m_tsmoothing != TSmoothingMode::NONE))
+        m_fft_input.reset(m_fft_size);
+#ifdef ENABLE_X86_SIMD
+        if(!HAVE_AVX2 || !calibration::prefer_builtin_fft(m_fft_size) || !m_rfft.init(m_fft_size))
+#endif
         {
-            m_tsmooth_buf[i].reset(count);
-            std::fill(m_tsmooth_buf[i].get(), m_tsmooth_buf[i].get() + count, 0.0f);
+            m_fft_output.reset(m_fft_size);
+            m_fft_plan = fftwf_plan_dft_r2c_1d((int)m_fft_size, m_fft_input.get(), m_fft_output.get(), FFTW_ESTIMATE);
         }
-        std::fill(m_decibels[i].get(), m_decibels[i].get() + count, m_meter_mode ? 0.0f : DB_MIN);
     }
-    if(spectrum_mode)
+
+    // window function
+    // cosine-sum windows are a short convolution of the spectrum, with FFTW the FFT runs on the raw input
+    // and only the bins in use are windowed afterwards (the in-tree FFT applies the window while loading instead)
+    if(spectrum_mode && (m_fft_plan != nullptr))
     {
-        m_fft_input.reset(m_fft_size);
-        m_fft_output.reset(m_fft_size);
-        m_fft_plan = fftwf_plan_dft_r2c_1d((int)m_fft_size, m_fft_input.get(), m_fft_output.get(), FFTW_ESTIMATE);
+        switch(m_window_func)
+        {
+        case FFTWindow::HANN:
+            m_spectral_radius = set_spectral_window({ 0.5f, 0.5f });
+            break;
+        case FFTWindow::HAMMING:
+            m_spectral_radius = set_spectral_window({ 0.53836f, 0.46164f });
+            break;
+        case FFTWindow::BLACKMAN:
+            m_spectral_radius = set_spectral_window({ 0.42f, 0.5f, 0.08f });
+            break;
+        case FFTWindow::BLACKMAN_HARRIS:
+            m_spectral_radius = set_spectral_window({ 0.35875f, 0.48829f, 0.14128f, 0.01168f });
+            break;
+        default:
+            break;
+        }
     }
 
-    // window function
-    if(m_window_func != FFTWindow::NONE)
+    if(m_spectral_radius > 0)
+    {
+        m_fft_windowed.reset(m_fft_size);
+        m_window_sum = m_spectral_taps[0] * (float)m_fft_size; // periodic window, the sum is a0 * N
+    }
+    else if(m_window_func != FFTWindow::NONE)
     {
         // precompute window coefficients
+        // periodic form (divided by N rather than N - 1), the same window the FFTW path applies to the spectrum
         m_window_coefficients.reset(m_fft_size);
-        const auto N = m_fft_size - 1;
+        const auto N = m_fft_size;
         constexpr auto pi2 = 2 * pi;
         constexpr auto pi4 = 4 * pi;
         constexpr auto pi6 = 6 * pi;
@@ -1247,18 +1915,40 @@ void WAVSource::update(obs_data_t *settings)
         m_window_sum = (float)m_fft_size;
 
     m_last_silent = false;
-    m_show = obs_source_showing(m_source);
+    m_show.store(obs_source_showing(m_source), std::memory_order_relaxed);
     m_retries = 0;
     m_next_retry = 0.0f;
 
+    // reserve capture buffers up front (with up to a second of sync slack) so capture_packet() doesn't reallocate
+    const auto capture_samples = ((m_display_mode == DisplayMode::WAVEFORM) || (m_display_mode == DisplayMode::VECTORSCOPE)) ? m_waveform_samples : m_fft_size;
+    for(auto& i : m_capturebufs)
+        circlebuf_reserve(&i, (capture_samples + m_capture_rate) * sizeof(float));
+    if(m_normalize_volume)
+        circlebuf_reserve(&m_rms_sync_buf, (m_input_rms_size + m_audio_info.samples_per_sec) * sizeof(float));
+
+    // publish what size queries and proc handlers need
+    auto shared = std::make_shared<SharedConfig>();
+    shared->samples_per_sec = m_audio_info.samples_per_sec;
+    shared->speakers = (uint32_t)m_audio_info.speakers;
+    if(m_meter_mode)
+        shared->width = (m_bar_width * m_capture_channels) + ((m_capture_channels > 1) ? m_bar_gap : 0);
+    else if(m_radial)
+        shared->width = (unsigned int)((m_height + m_deadzone) * 2);
+    else
+        shared->width = m_width;
+    shared->height = m_radial ? (unsigned int)((m_height + m_deadzone) * 2) : m_height;
+    m_shared.store(std::move(shared));
+
     recapture_audio();
-    m_capture_ts = os_gettime_ns();
+    m_capture_ts = now_ns();
     if(!m_meter_mode)
     {
         // fill input buffers with silent audio to avoid startup lag e.g. when changing settings
         for(auto i = 0u; i < m_capture_channels; ++i)
             circlebuf_push_back_zero(&m_capturebufs[i], m_fft_size * sizeof(float));
     }
+    m_capture_frames = m_capturebufs[0].size / sizeof(float);
+    m_filterbank_pos = m_capture_frames; // the silence above doesn't need filtering
 
     // precomupte interpolated indices
     if((m_display_mode == DisplayMode::CURVE) || (m_display_mode == DisplayMode::WAVEFORM))
@@ -1275,8 +1965,26 @@ void WAVSource::update(obs_data_t *settings)
         for(auto& i : m_interp_bufs)
             i.clear();
         m_interp_bufs[0].resize(m_capture_channels);
+        m_interp_bufs[2].resize(m_capture_channels); // gauss filter output
         m_num_bars = m_capture_channels;
     }
+    else if(m_display_mode == DisplayMode::VECTORSCOPE)
+    {
+        // points are drawn straight from the capture buffers
+        m_interp_indices.clear();
+        for(auto& i : m_interp_bufs)
+            i.clear();
+    }
+    else if(m_filterbank_enabled)
+    {
+        // one band per bar
+        m_interp_indices.resize(m_num_bars);
+        for(auto i = 0; i < m_num_bars; ++i)
+            m_interp_indices[i] = (float)i;
+        m_band_widths.assign(m_num_bars, 1);
+        for(auto& i : m_interp_bufs)
+            i.resize(m_num_bars);
+    }
     else
     {
         const auto bar_stride = m_bar_width + m_bar_gap;
@@ -1288,15 +1996,93 @@ void WAVSource::update(obs_data_t *settings)
             i.resize(m_num_bars);
     }
 
+    // output buffers, sized to the bin span chosen above
+    for(auto i = 0u; i < m_output_channels; ++i)
+    {
+        auto count = m_bin_count;
+        m_decibels[i].reset(count);
+        if((spectrum_mode || m_filterbank_enabled) && (m_tsmoothing != TSmoothingMode::NONE))
+        {
+            if(m_half_history)
+            {
+                m_tsmooth_half[i].reset(count);
+                std::fill(m_tsmooth_half[i].get(), m_tsmooth_half[i].get() + count, (uint16_t)0);
+            }
+            else
+            {
+                m_tsmooth_buf[i].reset(count);
+                std::fill(m_tsmooth_buf[i].get(), m_tsmooth_buf[i].get() + count, 0.0f);
+            }
+        }
+        std::fill(m_decibels[i].get(), m_decibels[i].get() + count, m_meter_mode ? 0.0f : DB_MIN);
+    }
+
+    // onset detection, previous frame's magnitudes for the spectral flux
+    m_onset_detection = m_onset_detection && spectrum_mode;
+    if(m_onset_detection)
+    {
+        for(auto i = 0u; i < m_capture_channels; ++i)
+        {
+            m_flux_prev[i].reset(m_bin_count);
+            std::fill(m_flux_prev[i].get(), m_flux_prev[i].get() + m_bin_count, 0.0f);
+        }
+    }
+    m_onset.reset(m_onset_sensitivity);
+
+    // long-term average spectrum, drawn behind the live curve
+    m_ltas_enabled = m_ltas_enabled && spectrum_mode && (m_display_mode == DisplayMode::CURVE);
+    if(m_ltas_enabled)
+    {
+        m_ltas.init(m_output_channels, m_bin_count, m_ltas_seconds);
+        for(auto i = 0u; i < m_output_channels; ++i)
+        {
+            m_ltas_db[i].reset(m_bin_count);
+            std::fill(m_ltas_db[i].get(), m_ltas_db[i].get() + m_bin_count, DB_MIN);
+        }
+    }
+    m_ltas_stale = false;
+
+    // spectrum history, sized for the frame rate
+    if(m_history_enabled && spectrum_mode)
+    {
+        SpectrumHistoryFormat format;
+        format.channels = m_stereo ? 2 : 1;
+        format.bins = (uint32_t)m_bin_count;
+        format.bin_start = (uint32_t)m_bin_start;
+        format.fft_size = (uint32_t)m_fft_size;
+        format.sample_rate = m_capture_rate;
+        format.sample_bytes = m_history_bytes;
+        auto frames = (uint64_t)(m_history_minutes * 60.0 * m_fps);
+        m_history.open(format, frames, m_history_path.c_str()); // only reopened when one of these changed
+    }
+    else
+        m_history.close();
+
+    m_latency.reset();
+    m_analyzed_ts = 0;
+
     // filter
     if(m_filter_mode == FilterMode::GAUSS)
         m_kernel = make_gauss_kernel(m_filter_radius);
 
+    // reduced resolution curves for sources drawn smaller than their size
+    if((m_display_mode == DisplayMode::CURVE) || (m_display_mode == DisplayMode::WAVEFORM))
+        init_curve_lods();
+
     // slope
-    if(m_slope > 0.0f)
+    if((m_slope > 0.0f) && m_filterbank_enabled)
+    {
+        // same curve as for the FFT bins, at the band centers
+        const auto nyquist = (float)m_audio_info.samples_per_sec / 2.0f;
+        const auto& centers = m_filterbank.centers();
+        m_slope_modifiers.reset(centers.size());
+        for(size_t i = 0; i < centers.size(); ++i)
+            m_slope_modifiers[i] = std::log10(log_interp(10.0f, 10000.0f, (centers[i] * m_slope) / nyquist));
+    }
+    else if(m_slope > 0.0f)
     {
         const auto num_mods = m_fft_size / 2;
-        const auto maxmod = (float)(num_mods - 1);
+        const auto maxmod = (float)((num_mods * m_decimation) - 1); // relative to the undecimated nyquist
         m_slope_modifiers.reset(num_mods);
         for(size_t i = 0; i < num_mods; ++i)
             m_slope_modifiers[i] = std::log10(log_interp(10.0f, 10000.0f, ((float)i * m_slope) / maxmod));
@@ -1329,6 +2115,9 @@ void WAVSource::update(obs_data_t *settings)
     if((m_rolloff_q > 0.0f) && (m_rolloff_rate > 0.0f))
         init_rolloff();
 
+    // filled curves are a quad and a height texture instead of a tristrip (the radial layout needs real geometry)
+    m_curve_fill = ((m_display_mode == DisplayMode::CURVE) || (m_display_mode == DisplayMode::WAVEFORM)) && (m_render_mode != RenderMode::LINE) && !m_radial;
+
     // vertex buffer must be rebuilt if the settings have changed
     // this must be done after m_num_bars has been initialized
     create_vbuf();
@@ -1336,89 +2125,370 @@ void WAVSource::update(obs_data_t *settings)
 
 void WAVSource::tick(float seconds)
 {
-    std::lock_guard lock(m_mtx);
+    if(m_replay != nullptr)
+    {
+        tick_replay(seconds);
+        return;
+    }
 
     m_tick_ts = os_gettime_ns();
+    auto captured = check_audio_capture(seconds);
+
+    // logged where the rings are drained, the packets logged ahead of it are the ones this tick mixes
+    if(m_recorder.active())
+        m_recorder.write_tick(m_tick_ts, seconds);
+
+    if(captured)
+        mix_audio();
 
     if(m_normalize_volume)
         update_input_rms();
 
-    if(!check_audio_capture(seconds))
+    if(!captured)
         return;
+
+    process_audio(seconds);
+}
+
+void WAVSource::process_audio(float seconds)
+{
     if(m_capture_channels == 0)
         return;
 
+    WAV_TRACE4(tick_start, this, (int)m_display_mode, (int)m_meter_mode, m_fft_size);
     if(m_meter_mode)
         tick_meter(seconds);
     else if(m_display_mode == DisplayMode::WAVEFORM)
-        tick_waveform(seconds);
+    {
+        if(m_scope)
+            tick_scope(seconds);
+        else
+            tick_waveform(seconds);
+    }
+    else if(m_display_mode == DisplayMode::VECTORSCOPE)
+        tick_vectorscope(seconds);
+    else if(m_filterbank_enabled)
+        tick_filterbank(seconds);
     else
+    {
+        if(m_ltas_enabled)
+        {
+            m_ltas.advance(m_tick_ts);
+            m_ltas_stale = true;
+        }
         tick_spectrum(seconds);
+        if(m_history)
+        {
+            const float *frame[2] = { m_decibels[0].get(), m_decibels[1].get() };
+            m_history.append(m_tick_ts, frame);
+        }
+    }
+    WAV_TRACE4(tick_end, this, (int)m_display_mode, (int)m_meter_mode, m_fft_size);
+
+    // newest audio the analysis used, anything held back for sync isn't shown yet
+    if((m_replay == nullptr) && (m_audio_ts != 0))
+        m_analyzed_ts = m_audio_ts - (uint64_t)std::max(get_audio_sync(m_tick_ts), (int64_t)0);
 }
 
 void WAVSource::render([[maybe_unused]] gs_effect_t *effect)
 {
-    std::lock_guard lock(m_mtx);
+    // once per analysis, the first render of the frame showing it
+    if(m_analyzed_ts != 0)
+    {
+        m_latency.record((int64_t)(os_gettime_ns() - m_analyzed_ts));
+        m_analyzed_ts = 0;
+    }
+
     if(m_last_silent && m_hide_on_silent)
         return;
     if(m_vbuf == nullptr)
         return;
 
+    WAV_TRACE2(render_start, this, gs_vertexbuffer_get_data(m_vbuf)->num);
     if((m_display_mode == DisplayMode::CURVE) || (m_display_mode == DisplayMode::WAVEFORM))
         render_curve(effect);
+    else if(m_display_mode == DisplayMode::VECTORSCOPE)
+        render_vectorscope(effect);
     else
         render_bars(effect);
+    WAV_TRACE2(render_end, this, gs_vertexbuffer_get_data(m_vbuf)->num);
+
+    if(m_latency_overlay)
+        render_latency_overlay();
+}
+
+void WAVSource::render_latency_overlay()
+{
+    // background, one bar per histogram bucket and a line at the 95th percentile, in the top left corner
+    constexpr auto buckets = LatencyTracker::BUCKETS;
+    constexpr auto num_verts = (buckets + 2) * 6;
+    if(m_overlay_vbuf == nullptr)
+    {
+        m_overlay_vbuf = vbuf_pool::acquire(num_verts);
+        if(m_overlay_vbuf == nullptr)
+            return;
+    }
+
+    uint32_t counts[buckets];
+    const auto peak = std::max(m_latency.histogram(counts), 1u);
+    const auto p95 = m_latency.stats().p95;
+    const auto width = std::min((float)m_width, 250.0f);
+    const auto height = std::min((float)m_height, 60.0f);
+    const auto bar_width = width / (float)buckets;
+
+    auto vbdata = gs_vertexbuffer_get_data(m_overlay_vbuf);
+    auto quad = [&](size_t index, float x1, float y1, float x2, float y2) {
+        auto verts = &vbdata->points[index * 6];
+        vec3_set(&verts[0], x1, y1, 0);
+        vec3_set(&verts[1], x2, y1, 0);
+        vec3_set(&verts[2], x1, y2, 0);
+        vec3_set(&verts[3], x2, y1, 0);
+        vec3_set(&verts[4], x1, y2, 0);
+        vec3_set(&verts[5], x2, y2, 0);
+    };
+    quad(0, 0.0f, 0.0f, width, height);
+    for(size_t i = 0; i < buckets; ++i)
+    {
+        auto x = (float)i * bar_width;
+        quad(i + 1, x, height * (1.0f - ((float)counts[i] / (float)peak)), x + std::max(bar_width - 1.0f, 1.0f), height);
+    }
+    auto x = std::clamp((float)p95 / (float)LatencyTracker::BUCKET_NS, 0.0f, (float)buckets) * bar_width;
+    quad(buckets + 1, x - 1.0f, 0.0f, x + 1.0f, height);
+    gs_vertexbuffer_flush(m_overlay_vbuf);
+
+    const vec4 colors[] = { { {{ 0.0f, 0.0f, 0.0f, 0.6f }} }, { {{ 1.0f, 1.0f, 1.0f, 0.8f }} }, { {{ 1.0f, 0.2f, 0.2f, 1.0f }} } };
+    const uint32_t ranges[][2] = { { 0, 6 }, { 6, buckets * 6 }, { (buckets + 1) * 6, 6 } };
+    auto tech = gs_effect_get_technique(m_shader, "Solid");
+    auto color_base = gs_effect_get_param_by_name(m_shader, "color_base");
+    gs_technique_begin(tech);
+    gs_load_vertexbuffer(m_overlay_vbuf);
+    gs_load_indexbuffer(nullptr);
+    for(auto i = 0; i < 3; ++i)
+    {
+        gs_effect_set_vec4(color_base, &colors[i]);
+        gs_technique_begin_pass(tech, 0);
+        gs_draw(GS_TRIS, ranges[i][0], ranges[i][1]);
+        gs_technique_end_pass(tech);
+    }
+    gs_load_vertexbuffer(nullptr);
+    gs_technique_end(tech);
+}
+
+void WAVSource::render_vectorscope([[maybe_unused]] gs_effect_t *effect)
+{
+    auto tech = gs_effect_get_technique(m_shader, "Solid");
+    auto color_base = gs_effect_get_param_by_name(m_shader, "color_base");
+
+    // the points were written at tick time, one upload for all of them
+    if(m_vector_count > 1)
+    {
+        gs_vertexbuffer_get_data(m_vbuf)->num = m_vector_count;
+        gs_vertexbuffer_flush(m_vbuf);
+        gs_effect_set_vec4(color_base, &m_color_base);
+        gs_technique_begin(tech);
+        gs_technique_begin_pass(tech, 0);
+        gs_load_vertexbuffer(m_vbuf);
+        gs_load_indexbuffer(nullptr);
+        if(!m_vector_lines)
+            gs_draw(GS_POINTS, 0, (uint32_t)m_vector_count);
+        else
+        {
+            // oldest to newest, the ring wraps at m_vector_head once full
+            const auto head = (m_vector_count == m_vector_capacity) ? m_vector_head : 0;
+            if((m_vector_count - head) > 1)
+                gs_draw(GS_LINESTRIP, (uint32_t)head, (uint32_t)(m_vector_count - head));
+            if(head > 1)
+                gs_draw(GS_LINESTRIP, 0, (uint32_t)head);
+        }
+        gs_load_vertexbuffer(nullptr);
+        gs_technique_end_pass(tech);
+        gs_technique_end(tech);
+    }
+
+    // correlation bar, filled from the center towards -1 (left) or +1 (right)
+    if(m_corr_vbuf == nullptr)
+        return;
+    const auto top = (float)(m_height - CORRELATION_HEIGHT);
+    const auto bottom = (float)m_height;
+    const auto center = (float)m_width / 2.0f;
+    const auto value = center + (m_correlation * center);
+    const float rects[2][2] = { { 0.0f, (float)m_width }, { std::min(center, value), std::max(center, value) + 1.0f } };
+    auto vbdata = gs_vertexbuffer_get_data(m_corr_vbuf);
+    for(auto i = 0; i < 2; ++i)
+    {
+        vec3_set(&vbdata->points[(i * 6) + 0], rects[i][0], top, 0);
+        vec3_set(&vbdata->points[(i * 6) + 1], rects[i][1], top, 0);
+        vec3_set(&vbdata->points[(i * 6) + 2], rects[i][0], bottom, 0);
+        vec3_set(&vbdata->points[(i * 6) + 3], rects[i][1], top, 0);
+        vec3_set(&vbdata->points[(i * 6) + 4], rects[i][1], bottom, 0);
+        vec3_set(&vbdata->points[(i * 6) + 5], rects[i][0], bottom, 0);
+    }
+    gs_vertexbuffer_flush(m_corr_vbuf);
+
+    const vec4 background = { {{ 0.0f, 0.0f, 0.0f, 0.6f }} };
+    gs_technique_begin(tech);
+    gs_load_vertexbuffer(m_corr_vbuf);
+    gs_load_indexbuffer(nullptr);
+    for(auto i = 0; i < 2; ++i)
+    {
+        gs_effect_set_vec4(color_base, i ? &m_color_base : &background);
+        gs_technique_begin_pass(tech, 0);
+        gs_draw(GS_TRIS, i * 6, 6);
+        gs_technique_end_pass(tech);
+    }
+    gs_load_vertexbuffer(nullptr);
+    gs_technique_end(tech);
 }
 
 void WAVSource::render_curve([[maybe_unused]] gs_effect_t *effect)
 {
-    //std::lock_guard lock(m_mtx); // now locked in render()
     //if(m_last_silent)
     //    return;
 
-    auto tech = get_shader_tech();
-    
     const auto center = (float)m_height / 2;
-    //const auto right = (float)m_width;
+    const auto cpos = m_stereo ? center : (float)m_height;
+    const auto channel_offset = m_channel_spacing * 0.5f;
+
+    // fewer points when the graph is drawn smaller than its size, minpos is reported in graph space
+    const auto lod = select_lod(curve_footprint());
+    const auto x_step = lod ? (float)(m_width - 1) / (float)(m_curve_lods[lod].indices.size() - 1) : 1.0f;
+    WAV_TRACE2(curve_lod, this, lod);
+
+    // long-term average underneath in a single color
+    if(m_ltas_enabled && (m_ltas.frames() > 0))
+    {
+        if(m_ltas_stale)
+            update_ltas_db();
+        auto miny = cpos;
+        auto minpos = 0u;
+        map_curve(m_ltas_db, lod, miny, minpos);
+        set_shader_vars(cpos, miny, (float)minpos * x_step, channel_offset, 0.0f, cpos - channel_offset);
+        gs_effect_set_vec4(gs_effect_get_param_by_name(m_shader, "color_base"), &m_color_ltas);
+        draw_curve(gs_effect_get_technique(m_shader, m_curve_fill ? "FillSolid" : (m_radial ? "Radial" : "Solid")), lod);
+    }
+
+    auto miny = cpos;
+    auto minpos = 0u;
+    map_curve(m_decibels, lod, miny, minpos);
+    set_shader_vars(cpos, miny, (float)minpos * x_step, channel_offset, 0.0f, cpos - channel_offset);
+    draw_curve(get_shader_tech(), lod);
+}
+
+// the average in dB, once per analysis and only while it's drawn
+// volume normalization is already in the sums, the roll-off is applied here the same way as to the live curve
+void WAVSource::update_ltas_db()
+{
+    const auto rolloff = (m_rolloff_q > 0.0f) && (m_rolloff_rate > 0.0f);
+    for(auto channel = 0u; channel < (m_stereo ? 2u : 1u); ++channel)
+    {
+        auto db = m_ltas_db[channel].get();
+        m_ltas.mean_db(channel, db, DB_MIN);
+        if(rolloff)
+            for(size_t i = (m_bin_start > 0) ? 0 : 1; i < m_bin_count; ++i)
+                db[i] = std::max(db[i] - m_rolloff_modifiers[m_bin_start + i], DB_MIN);
+    }
+    m_ltas_stale = false;
+}
+
+float WAVSource::curve_footprint()
+{
+    // libobs has no projection getter, infer it: render targets (filters, transitions, the main output)
+    // are set up with an ortho matrix covering the target, the swap chain is either the canvas (preview, multiview)
+    // or this source on its own (properties, projectors), take the smaller of the two so the estimate errs large
+    obs_video_info ovi{};
+    if(!obs_get_video_info(&ovi))
+        return (float)m_width;
+    gs_rect viewport;
+    gs_get_viewport(&viewport);
+    float ortho_w, ortho_h;
+    auto target = gs_get_render_target();
+    if(target != nullptr)
+    {
+        ortho_w = (float)gs_texture_get_width(target);
+        ortho_h = (float)gs_texture_get_height(target);
+    }
+    else
+    {
+        ortho_w = (float)std::min(ovi.base_width, width());
+        ortho_h = (float)std::min(ovi.base_height, height());
+    }
+    if((ortho_w <= 0.0f) || (ortho_h <= 0.0f))
+        return (float)m_width;
+    const auto sx = (float)viewport.cx / ortho_w;
+    const auto sy = (float)viewport.cy / ortho_h;
+
+    // length of the graph's x and y axes in pixels after the scene transform
+    matrix4 world;
+    gs_matrix_get(&world);
+    const auto xscale = std::hypot(world.x.x * sx, world.x.y * sy);
+    const auto yscale = std::hypot(world.y.x * sx, world.y.y * sy);
+
+    if(m_radial)
+    {
+        // points are spread along the outer edge of the arc
+        constexpr auto pi2 = std::numbers::pi_v<float> * 2.0f;
+        return ((float)m_height + m_deadzone) * pi2 * m_radial_arc * std::max(xscale, yscale);
+    }
+    return (float)m_width * xscale;
+}
+
+int WAVSource::select_lod(float footprint) const
+{
+    // coarsest level that still has a point per pixel
+    auto lod = 0;
+    while((lod + 1 < m_num_lods) && ((float)m_curve_lods[lod + 1].indices.size() >= footprint))
+        ++lod;
+    return lod;
+}
+
+void WAVSource::map_curve(const AVXBufR *data, int lod, float& miny, unsigned int& minpos)
+{
+    const auto& indices = lod ? m_curve_lods[lod].indices : m_interp_indices;
+    const auto& interp_kernel = lod ? m_curve_lods[lod].interp_kernel : m_interp_kernel;
+    const auto& kernel = lod ? m_curve_lods[lod].kernel : m_kernel;
+    const auto points = (unsigned int)indices.size();
+    const auto center = (float)m_height / 2;
     const auto bottom = (float)m_height;
     const auto dbrange = m_ceiling - m_floor;
     const auto cpos = m_stereo ? center : bottom;
     const auto channel_offset = m_channel_spacing * 0.5f;
 
+    // apply_filter() works on the whole buffer, spare capacity keeps this from allocating
+    for(auto& i : m_interp_bufs)
+        i.resize(points);
+
     // interpolation
-    auto miny = cpos;
-    auto minpos = 0u;
     for(auto channel = 0u; channel < (m_stereo ? 2u : 1u); ++channel)
     {
         if(m_interp_mode != InterpMode::POINT)
         {
-            const auto sz = (m_display_mode == DisplayMode::WAVEFORM) ? m_fft_size : m_fft_size / 2u;
+            const auto sz = m_bin_count;
 #ifdef ENABLE_X86_SIMD
             if(HAVE_AVX)
-                apply_interp_filter_fma3(m_decibels[channel].get(), sz, m_interp_indices, m_interp_kernel, m_interp_bufs[channel]);
+                apply_interp_filter_fma3(data[channel].get(), sz, indices, interp_kernel, m_interp_bufs[channel]);
             else
-                apply_interp_filter(m_decibels[channel].get(), sz, m_interp_indices, m_interp_kernel, m_interp_bufs[channel]);
+                apply_interp_filter(data[channel].get(), sz, indices, interp_kernel, m_interp_bufs[channel]);
 #else
-            apply_interp_filter(m_decibels[channel].get(), sz, m_interp_indices, m_interp_kernel, m_interp_bufs[channel]);
+            apply_interp_filter(data[channel].get(), sz, indices, interp_kernel, m_interp_bufs[channel]);
 #endif
         }
         else
-            for(auto i = 0u; i < m_width; ++i)
-                m_interp_bufs[channel][i] = m_decibels[channel][(int)m_interp_indices[i]];
+            for(auto i = 0u; i < points; ++i)
+                m_interp_bufs[channel][i] = data[channel][(int)indices[i]];
 
         if(m_filter_mode != FilterMode::NONE)
         {
 #ifdef ENABLE_X86_SIMD
             if(HAVE_AVX)
-                std::swap(m_interp_bufs[channel], apply_filter_fma3(m_interp_bufs[channel], m_kernel, m_interp_bufs[2]));
+                std::swap(m_interp_bufs[channel], apply_filter_fma3(m_interp_bufs[channel], kernel, m_interp_bufs[2]));
             else
-                std::swap(m_interp_bufs[channel], apply_filter(m_interp_bufs[channel], m_kernel, m_interp_bufs[2]));
+                std::swap(m_interp_bufs[channel], apply_filter(m_interp_bufs[channel], kernel, m_interp_bufs[2]));
 #else
-            std::swap(m_interp_bufs[channel], apply_filter(m_interp_bufs[channel], m_kernel, m_interp_bufs[2]));
+            std::swap(m_interp_bufs[channel], apply_filter(m_interp_bufs[channel], kernel, m_interp_bufs[2]));
 #endif // ENABLE_X86_SIMD
         }
         
-        for(auto i = 0u; i < m_width; ++i)
+        for(auto i = 0u; i < points; ++i)
         {
             auto val = lerp(0.0f, cpos - channel_offset, std::clamp(m_ceiling - m_interp_bufs[channel][i], 0.0f, (float)dbrange) / dbrange);
             if(val < miny)
@@ -1431,20 +2501,34 @@ void WAVSource::render_curve([[maybe_unused]] gs_effect_t *effect)
 
         if(m_mirror_freq_axis)
         {
-            const auto half = (m_width / 2u);
-            for(auto i = half + 1; i < m_width; ++i)
+            const auto half = (points / 2u);
+            for(auto i = half + 1; i < points; ++i)
                 m_interp_bufs[channel][i] = m_interp_bufs[channel][half - (i - half)];
         }
     }
+}
+
+void WAVSource::draw_curve(gs_technique_t *tech, int lod)
+{
+    const auto vbuf = lod ? m_curve_lods[lod].vbuf : m_vbuf;
+    const auto points = (unsigned int)m_interp_bufs[0].size();
+    const auto center = (float)m_height / 2;
+    const auto bottom = (float)m_height;
+    const auto cpos = m_stereo ? center : bottom;
+    const auto channel_offset = m_channel_spacing * 0.5f;
 
-    set_shader_vars(cpos, miny, (float)minpos, channel_offset, 0.0f, cpos - channel_offset);
+    if(m_curve_fill)
+    {
+        draw_curve_fill(tech, lod ? m_curve_lods[lod].heights : m_heights, points, cpos, channel_offset);
+        return;
+    }
 
     gs_technique_begin(tech);
     gs_technique_begin_pass(tech, 0);
-    gs_load_vertexbuffer(m_vbuf);
+    gs_load_vertexbuffer(vbuf);
     gs_load_indexbuffer(nullptr);
 
-    auto vbdata = gs_vertexbuffer_get_data(m_vbuf);
+    auto vbdata = gs_vertexbuffer_get_data(vbuf);
 
     for(auto channel = 0u; channel < (m_stereo ? 2u : 1u); ++channel)
     {
@@ -1453,7 +2537,7 @@ void WAVSource::render_curve([[maybe_unused]] gs_effect_t *effect)
             offset = -offset;
         auto bot = cpos - offset;
 
-        for(auto i = 0u; i < m_width; ++i)
+        for(auto i = 0u; i < points; ++i)
         {
             auto val = m_interp_bufs[channel][i];
             if(m_render_mode == RenderMode::LINE)
@@ -1473,7 +2557,7 @@ void WAVSource::render_curve([[maybe_unused]] gs_effect_t *effect)
             }
         }
 
-        gs_vertexbuffer_flush(m_vbuf);
+        gs_vertexbuffer_flush(vbuf);
 
         gs_draw((m_render_mode != RenderMode::LINE) ? GS_TRISTRIP : GS_LINESTRIP, 0, (uint32_t)vbdata->num);
     }
@@ -1483,9 +2567,41 @@ void WAVSource::render_curve([[maybe_unused]] gs_effect_t *effect)
     gs_technique_end(tech);
 }
 
+void WAVSource::draw_curve_fill(gs_technique_t *tech, gs_texture_t *heights, unsigned int points, float cpos, float channel_offset)
+{
+    if(heights == nullptr)
+        return;
+
+    // one float per column instead of rewriting the y of every vertex
+    uint8_t *ptr;
+    uint32_t linesize;
+    if(!gs_texture_map(heights, &ptr, &linesize))
+        return;
+    for(auto channel = 0u; channel < (m_stereo ? 2u : 1u); ++channel)
+        memcpy(ptr + (channel * linesize), m_interp_bufs[channel].data(), points * sizeof(float));
+    gs_texture_unmap(heights);
+
+    gs_effect_set_texture(gs_effect_get_param_by_name(m_shader, "fill_heights"), heights);
+    gs_effect_set_float(gs_effect_get_param_by_name(m_shader, "fill_points"), (float)points);
+    gs_effect_set_float(gs_effect_get_param_by_name(m_shader, "fill_center"), cpos);
+    gs_effect_set_float(gs_effect_get_param_by_name(m_shader, "fill_offset"), channel_offset);
+    gs_effect_set_bool(gs_effect_get_param_by_name(m_shader, "fill_stereo"), m_stereo);
+    gs_effect_set_bool(gs_effect_get_param_by_name(m_shader, "fill_cubic"), m_interp_mode == InterpMode::CATROM);
+    gs_effect_set_float(gs_effect_get_param_by_name(m_shader, "graph_width"), (float)(m_width - 1));
+    gs_effect_set_float(gs_effect_get_param_by_name(m_shader, "graph_height"), (float)m_height);
+
+    gs_technique_begin(tech);
+    gs_technique_begin_pass(tech, 0);
+    gs_load_vertexbuffer(m_vbuf);
+    gs_load_indexbuffer(nullptr);
+    gs_draw(GS_TRISTRIP, 0, 4);
+    gs_load_vertexbuffer(nullptr);
+    gs_technique_end_pass(tech);
+    gs_technique_end(tech);
+}
+
 void WAVSource::render_bars([[maybe_unused]] gs_effect_t *effect)
 {
-    //std::lock_guard lock(m_mtx); // now locked in render()
     //if(m_last_silent)
     //    return;
 
@@ -1526,11 +2642,11 @@ void WAVSource::render_bars([[maybe_unused]] gs_effect_t *effect)
             {
 #ifdef ENABLE_X86_SIMD
                 if(HAVE_AVX)
-                    apply_interp_filter_fma3(m_decibels[channel].get(), m_fft_size / 2, m_band_widths, m_interp_indices, m_interp_kernel, m_interp_bufs[channel]);
+                    apply_interp_filter_fma3(m_decibels[channel].get(), m_bin_count, m_band_widths, m_interp_indices, m_interp_kernel, m_interp_bufs[channel]);
                 else
-                    apply_interp_filter(m_decibels[channel].get(), m_fft_size / 2, m_band_widths, m_interp_indices, m_interp_kernel, m_interp_bufs[channel]);
+                    apply_interp_filter(m_decibels[channel].get(), m_bin_count, m_band_widths, m_interp_indices, m_interp_kernel, m_interp_bufs[channel]);
 #else
-                apply_interp_filter(m_decibels[channel].get(), m_fft_size / 2, m_band_widths, m_interp_indices, m_interp_kernel, m_interp_bufs[channel]);
+                apply_interp_filter(m_decibels[channel].get(), m_bin_count, m_band_widths, m_interp_indices, m_interp_kernel, m_interp_bufs[channel]);
 #endif
             }
             else
@@ -1694,6 +2810,15 @@ gs_technique_t *WAVSource::get_shader_tech()
         else
             techname = "Radial";
     }
+    else if(m_curve_fill)
+    {
+        if(m_render_mode == RenderMode::GRADIENT)
+            techname = "FillGradient";
+        else if(m_render_mode == RenderMode::RANGE)
+            techname = "FillRange";
+        else
+            techname = "FillSolid";
+    }
     else if(m_render_mode == RenderMode::GRADIENT)
         techname = "Gradient";
     else if(m_render_mode == RenderMode::RANGE)
@@ -1778,14 +2903,12 @@ void WAVSource::set_shader_vars(float cpos, float miny, float minpos, float chan
 
 void WAVSource::show()
 {
-    std::lock_guard lock(m_mtx);
-    m_show = true;
+    m_show.store(true, std::memory_order_relaxed);
 }
 
 void WAVSource::hide()
 {
-    std::lock_guard lock(m_mtx);
-    m_show = false;
+    m_show.store(false, std::memory_order_relaxed);
 }
 
 void WAVSource::register_source()
@@ -1798,6 +2921,8 @@ void WAVSource::register_source()
         arch += " AVX";
     if(HAVE_FMA3)
         arch += " FMA3";
+    if(HAVE_F16C)
+        arch += " F16C";
     arch += " SSE2";
 #else
     arch = " Generic";
@@ -1806,6 +2931,11 @@ void WAVSource::register_source()
     LogInfo << "Registered v" WAVEFORM_VERSION " " WAVEFORM_ARCH;
     LogInfo << "Using CPU capabilities:" << arch;
 
+#if defined(ENABLE_X86_SIMD) && defined(ENABLE_CALIBRATION)
+    auto cpu_id = std::string(CPU_INFO.vendor) + " " + std::to_string(CPU_INFO.family) + "." + std::to_string(CPU_INFO.model) + "." + std::to_string(CPU_INFO.stepping);
+    calibration::init(cpu_id.c_str(), HAVE_AVX, HAVE_AVX2);
+#endif
+
     obs_source_info info{};
     info.id = MODULE_NAME "_source";
     info.type = OBS_SOURCE_TYPE_INPUT;
@@ -1827,30 +2957,23 @@ void WAVSource::register_source()
     obs_register_source(&info);
 }
 
-void WAVSource::capture_audio([[maybe_unused]] obs_source_t *source, const audio_data *audio, bool muted)
+void WAVSource::capture_packet(const audio_data *audio, bool muted)
 {
-    static_assert(AUDIO_OUTPUT_FRAMES > 0, "AUDIO_OUTPUT_FRAMES must be greater than zero."); // sanity check
-    if(audio == nullptr)
-        return;
-    if(!m_mtx.try_lock_for(std::chrono::milliseconds(10)))
-        return;
-    std::lock_guard lock(m_mtx, std::adopt_lock);
-    if(((m_audio_source == nullptr) && !m_output_bus_captured) || (m_capture_channels == 0))
-        return;
     assert((m_channel_base >= 0) && (m_channel_base < (int)get_audio_channels(m_audio_info.speakers)));
     assert((m_channel_base == 0) || (m_capture_channels == 1));
 
-    // audio sync
-    m_capture_ts = os_gettime_ns();
+    // audio sync, packets are drained from the rings at tick time
+    m_capture_ts = m_tick_ts;
     auto audio_len = audio_frames_to_ns(m_audio_info.samples_per_sec, audio->frames);
     auto delta = std::max(audio->timestamp, m_capture_ts) - std::min(audio->timestamp, m_capture_ts);
     if(delta > MAX_TS_DELTA) // attempt to handle extreme / bogus timestamps (e.g. VLC)
         m_audio_ts = m_capture_ts;
     else
         m_audio_ts = audio->timestamp + audio_len;
-    const auto bufsz = ((m_display_mode == DisplayMode::WAVEFORM) ? m_waveform_samples : m_fft_size) * sizeof(float);
+    m_audio_ts -= audio_frames_to_ns(m_audio_info.samples_per_sec, m_decimators[0].delay()); // the decimation lowpass lags its input
+    const auto bufsz = (((m_display_mode == DisplayMode::WAVEFORM) || (m_display_mode == DisplayMode::VECTORSCOPE)) ? m_waveform_samples : m_fft_size) * sizeof(float);
     const int64_t dtaudio = get_audio_sync(m_capture_ts);
-    const size_t dtsamples = (dtaudio > 0) ? (size_t)ns_to_audio_frames(m_audio_info.samples_per_sec, (uint64_t)dtaudio) : 0;
+    const size_t dtsamples = (dtaudio > 0) ? (size_t)ns_to_audio_frames(m_capture_rate, (uint64_t)dtaudio) : 0;
 
     // RMS
     if(m_normalize_volume)
@@ -1888,11 +3011,32 @@ void WAVSource::capture_audio([[maybe_unused]] obs_source_t *source, const audio
     {
         auto j = i - m_channel_base;
         assert((j == 0) || (j == 1));
-        if((muted && !m_ignore_mute) || (audio->data[i] == nullptr))
+        const auto prev_size = m_capturebufs[j].size;
+        if(m_decimation > 1)
+        {
+            if((muted && !m_ignore_mute) || (audio->data[i] == nullptr))
+                circlebuf_push_back_zero(&m_capturebufs[j], m_decimators[j].skip(audio->frames) * sizeof(float));
+            else
+            {
+                auto src = (const float*)audio->data[i];
+                for(size_t frames = audio->frames; frames > 0;)
+                {
+                    auto count = std::min(frames, Decimator::MAX_BLOCK);
+                    auto out = m_decimators[j].process(src, count, m_decimate_buf.get());
+                    circlebuf_push_back(&m_capturebufs[j], m_decimate_buf.get(), out * sizeof(float));
+                    src += count;
+                    frames -= count;
+                }
+            }
+        }
+        else if((muted && !m_ignore_mute) || (audio->data[i] == nullptr))
             circlebuf_push_back_zero(&m_capturebufs[j], sz);
         else
             circlebuf_push_back(&m_capturebufs[j], audio->data[i], sz);
 
+        if(j == 0)
+            m_capture_frames += (m_capturebufs[0].size - prev_size) / sizeof(float);
+
         const size_t max_size = (dtsamples * sizeof(float)) + bufsz;
         auto total = m_capturebufs[j].size;
         if(total > max_size)
@@ -1900,7 +3044,257 @@ void WAVSource::capture_audio([[maybe_unused]] obs_source_t *source, const audio
     }
 }
 
-void WAVSource::capture_output_bus([[maybe_unused]] size_t mix_idx, const audio_data *audio)
+void WAVSource::capture_mix_input(MixInput *input, const audio_data *audio, bool muted, uint64_t now)
+{
+    static_assert(AUDIO_OUTPUT_FRAMES > 0, "AUDIO_OUTPUT_FRAMES must be greater than zero."); // sanity check
+    if((audio == nullptr) || (input->channels == 0))
+        return;
+    WAV_TRACE2(capture_start, this, audio->frames);
+
+    // the packet as it arrived, before muting and the timestamp check
+    if(m_recorder.active())
+        m_recorder.write_packet((uint8_t)(input - m_mix_inputs), now, audio, muted, input->planes);
+
+    const float *planes[AudioRing::MAX_CHANNELS]{};
+    if(!muted || input->ignore_mute)
+        for(auto channel = 0u; channel < input->channels; ++channel)
+            planes[channel] = (const float*)audio->data[input->channel_base + channel];
+
+    // same handling of bogus timestamps as capture_packet()
+    auto end_ts = audio->timestamp + audio_frames_to_ns(input->rate, audio->frames);
+    if((std::max(end_ts, now) - std::min(end_ts, now)) > MAX_TS_DELTA)
+        end_ts = now;
+    input->ring.push(planes, input->channels, audio->frames, end_ts);
+    WAV_TRACE2(capture_end, this, audio->frames);
+}
+
+void WAVSource::capture_output_bus(MixInput *input, const audio_data *audio, uint64_t now)
+{
+    WAV_TRACE2(capture_start, this, audio->frames);
+    if(m_recorder.active())
+        m_recorder.write_packet((uint8_t)(input - m_mix_inputs), now, audio, false, input->planes);
+
+    // the selected planes go straight from the mix into the ring
+    // mix timestamps are monotonic, unlike source timestamps they need no sanity check
+    const float *planes[AudioRing::MAX_CHANNELS]{};
+    for(auto channel = 0u; channel < input->channels; ++channel)
+        planes[channel] = (const float*)audio->data[input->channel_base + channel];
+    input->ring.push(planes, input->channels, audio->frames, audio->timestamp + audio_frames_to_ns(input->rate, audio->frames));
+    WAV_TRACE2(capture_end, this, audio->frames);
+}
+
+int WAVSource::set_spectral_window(std::initializer_list<float> coefficients)
 {
-    capture_audio(nullptr, audio, false);
+    // w[n] = a0 - a1 * cos(2pi * n / N) + a2 * cos(4pi * n / N) - ...
+    // each cosine term spreads half its weight to the bins on either side, with alternating sign
+    auto m = 0;
+    for(auto a : coefficients)
+    {
+        m_spectral_taps[m] = (m == 0) ? a : ((m & 1) ? -0.5f : 0.5f) * a;
+        ++m;
+    }
+    return m - 1;
+}
+
+const fftwf_complex *WAVSource::window_spectrum(size_t first, size_t count)
+{
+    if(m_spectral_radius == 0)
+        return m_fft_output.get();
+
+    auto spectrum = &m_fft_output[0][0];
+    auto output = &m_fft_windowed[first][0];
+    const auto bins = (m_fft_size / 2) + 1;
+#ifdef ENABLE_X86_SIMD
+    if(HAVE_AVX) // filter_fma3.cpp is built with AVX as well as FMA
+        spectral_window_fma3(spectrum, bins, m_spectral_taps, m_spectral_radius, first, count, output);
+    else
+#endif
+        spectral_window(spectrum, bins, m_spectral_taps, m_spectral_radius, first, count, output);
+    return m_fft_windowed.get();
+}
+
+void WAVSource::detect_onsets(float flux)
+{
+    if(!m_onset.process(flux, m_tick_ts))
+        return;
+
+    uint8_t stack[128];
+    calldata_t cd;
+    calldata_init_fixed(&cd, stack, sizeof(stack));
+    calldata_set_ptr(&cd, "source", m_source);
+    calldata_set_float(&cd, "strength", m_onset.strength());
+    calldata_set_float(&cd, "bpm", m_onset.bpm());
+    signal_handler_signal(obs_source_get_signal_handler(m_source), "onset", &cd);
+}
+
+void WAVSource::get_onset_info(calldata_t *cd)
+{
+    // detector state belongs to the graphics thread (runs inline if called from there)
+    struct Task { WAVSource *self; calldata_t *cd; } task{ this, cd };
+    obs_queue_task(OBS_TASK_GRAPHICS, [](void *param) {
+        auto task = static_cast<Task*>(param);
+        task->self->write_onset_info(task->cd);
+        }, &task, true);
+}
+
+void WAVSource::write_onset_info(calldata_t *cd)
+{
+    calldata_set_bool(cd, "enabled", m_onset_detection);
+    calldata_set_float(cd, "flux", m_onset.flux());
+    calldata_set_float(cd, "threshold", m_onset.threshold());
+    calldata_set_float(cd, "bpm", m_onset.bpm());
+    calldata_set_int(cd, "count", (long long)m_onset.onset_count());
+    calldata_set_int(cd, "last_onset", (long long)m_onset.last_onset());
+}
+
+void WAVSource::get_latency_info(calldata_t *cd)
+{
+    struct Task { WAVSource *self; calldata_t *cd; } task{ this, cd };
+    obs_queue_task(OBS_TASK_GRAPHICS, [](void *param) {
+        auto task = static_cast<Task*>(param);
+        task->self->write_latency_info(task->cd);
+        }, &task, true);
+}
+
+void WAVSource::get_correlation(calldata_t *cd)
+{
+    struct Task { WAVSource *self; calldata_t *cd; } task{ this, cd };
+    obs_queue_task(OBS_TASK_GRAPHICS, [](void *param) {
+        auto task = static_cast<Task*>(param);
+        task->self->write_correlation(task->cd);
+        }, &task, true);
+}
+
+void WAVSource::write_correlation(calldata_t *cd)
+{
+    calldata_set_bool(cd, "enabled", m_display_mode == DisplayMode::VECTORSCOPE);
+    calldata_set_float(cd, "correlation", m_correlation);
+}
+
+void WAVSource::write_latency_info(calldata_t *cd)
+{
+    // milliseconds
+    const auto stats = m_latency.stats();
+    calldata_set_int(cd, "count", (long long)stats.count);
+    calldata_set_float(cd, "min", (double)stats.min / 1000000.0);
+    calldata_set_float(cd, "mean", (double)stats.mean / 1000000.0);
+    calldata_set_float(cd, "p50", (double)stats.p50 / 1000000.0);
+    calldata_set_float(cd, "p95", (double)stats.p95 / 1000000.0);
+    calldata_set_float(cd, "p99", (double)stats.p99 / 1000000.0);
+    calldata_set_float(cd, "max", (double)stats.max / 1000000.0);
+}
+
+void WAVSource::start_capture_log(const char *path)
+{
+    auto shared = m_shared.load();
+    if((path == nullptr) || (*path == '\0') || (shared == nullptr))
+        return;
+    obs_audio_info info{};
+    info.samples_per_sec = shared->samples_per_sec;
+    info.speakers = (speaker_layout)shared->speakers;
+    m_recorder.open(path, info);
+}
+
+void WAVSource::stop_capture_log()
+{
+    m_recorder.close();
+}
+
+void WAVSource::replay_capture_log(const char *path, double speed)
+{
+    if((path == nullptr) || (*path == '\0'))
+        return;
+
+    // replay state belongs to the graphics thread (runs inline if called from there)
+    struct Task { WAVSource *self; const char *path; double speed; } task{ this, path, speed };
+    obs_queue_task(OBS_TASK_GRAPHICS, [](void *param) {
+        auto task = static_cast<Task*>(param);
+        task->self->start_replay(task->path, task->speed);
+        }, &task, true);
+}
+
+void WAVSource::start_replay(const char *path, double speed)
+{
+    auto replay = std::make_unique<CaptureReplay>();
+    if(!replay->open(path))
+        return;
+    const auto& header = replay->header();
+    if(header.samples_per_sec != m_audio_info.samples_per_sec)
+    {
+        LogWarn << "Capture log sample rate (" << header.samples_per_sec << " Hz) does not match OBS (" << m_audio_info.samples_per_sec << " Hz)";
+        return;
+    }
+    // the packets carry a plane per channel of the layout they were recorded with
+    if(header.speakers != (uint32_t)m_audio_info.speakers)
+    {
+        LogWarn << "Capture log speaker layout (" << header.speakers << ", " << get_audio_channels((speaker_layout)header.speakers) << " channels) does not match OBS ("
+            << (uint32_t)m_audio_info.speakers << ", " << get_audio_channels(m_audio_info.speakers) << " channels)";
+        return;
+    }
+
+    // picks up from the current capture buffers, like live capture after update()
+    m_replay = std::move(replay);
+    replay_mix_inputs();
+    m_replay_speed = speed;
+    m_replay_wall_ts = os_gettime_ns();
+    m_replay_clock = m_replay->start_ts();
+    m_capture_ts = m_replay_clock;
+    LogInfo << "Replaying capture log \"" << path << "\" at " << speed << "x";
+}
+
+void WAVSource::tick_replay([[maybe_unused]] float seconds)
+{
+    // replay the records up to the log time corresponding to the current wall time, the same way live capture sees them
+    // the pipeline only ever sees the recorded timestamps, so the results don't depend on playback speed
+    // a tick handles at most MAX_REPLAY_RECORDS, a long log replayed as fast as possible must not hold up the graphics thread
+    auto target = std::numeric_limits<uint64_t>::max();
+    if(m_replay_speed > 0.0)
+        target = m_replay->start_ts() + (uint64_t)((double)(os_gettime_ns() - m_replay_wall_ts) * m_replay_speed);
+
+    for(auto count = 0; count < MAX_REPLAY_RECORDS; ++count)
+    {
+        auto rec = m_replay->peek();
+        if(rec == nullptr)
+        {
+            LogInfo << "Capture log replay finished";
+            stop_replay();
+            return;
+        }
+        if(rec->time_ns > target)
+            return;
+
+        m_replay_clock = rec->time_ns;
+        if(rec->type == CaptureRecordType::PACKET)
+        {
+            // packets of inputs the log has but the source doesn't are dropped
+            if(rec->source < m_mix_count)
+            {
+                auto& input = m_mix_inputs[rec->source];
+                if(p_equ(input.name.c_str(), P_OUTPUT_BUS))
+                    capture_output_bus(&input, &m_replay->packet(), m_replay_clock);
+                else
+                    capture_mix_input(&input, &m_replay->packet(), rec->muted != 0, m_replay_clock);
+            }
+        }
+        else
+        {
+            // same order as tick()
+            m_tick_ts = m_replay_clock;
+            mix_audio();
+            if(m_normalize_volume)
+                update_input_rms();
+            process_audio((float)rec->frames / 1000000.0f);
+        }
+        m_replay->pop();
+    }
+}
+
+void WAVSource::stop_replay()
+{
+    m_replay.reset();
+    release_mix_inputs();
+
+    // resume live capture on the next tick
+    m_retries = 0;
+    m_next_retry = 0.0f;
 }
@@ -16,9 +16,12 @@
 */
 
 #pragma once
-#include <mutex>
+#include <memory>
+#include <atomic>
+#include <initializer_list>
 #include <obs-module.h>
 #include <util/bmem.h>
+#include <util/platform.h>
 #include <graphics/vec3.h>
 #include <graphics/vec4.h>
 #include <fftw3.h>
@@ -26,7 +29,20 @@
 #include <assert.h>
 #include "module.hpp"
 #include "aligned_buffer.hpp"
+#include "half.hpp"
 #include "filter.hpp"
+#include "fft.hpp"
+#include "decimator.hpp"
+#include "filterbank.hpp"
+#include "capture_log.hpp"
+#include "audio_ring.hpp"
+#include "onset.hpp"
+#include "latency.hpp"
+#include "ballistics.hpp"
+#include "ltas.hpp"
+#include "spectrum_history.hpp"
+#include "snapshot.hpp"
+#include "trace.hpp"
 
 using AVXBufR = AlignedBuffer<float>;
 using AVXBufC = AlignedBuffer<fftwf_complex>;
@@ -371,7 +387,8 @@ enum class DisplayMode
     STEPPED_BAR,
     METER,
     STEPPED_METER,
-    WAVEFORM
+    WAVEFORM,
+    VECTORSCOPE
 };
 
 enum class ChannelMode
@@ -381,17 +398,50 @@ enum class ChannelMode
     SINGLE
 };
 
+class WAVSource;
+
+// configuration read outside of the graphics thread (source size queries, proc handlers)
+// immutable once published, update() swaps in a new one
+struct SharedConfig
+{
+    uint32_t samples_per_sec = 0;
+    uint32_t speakers = 0;
+    unsigned int width = 0;     // source size as reported to OBS
+    unsigned int height = 0;
+};
+
+// one of the sources mixed together ahead of the analysis
+// the capture callback only touches the ring and reads the capture config, everything else is owned by the graphics thread
+struct MixInput
+{
+    WAVSource *owner = nullptr;
+    obs_weak_source_t *source = nullptr;
+    bool output_bus = false;        // connected via audio_output_connect()
+    bool replayed = false;          // fed from a capture log instead
+    unsigned int channel_base = 0;  // planes to capture and the mix rate, fixed while connected
+    unsigned int channels = 0;      // the capture callbacks read these instead of the shared config
+    uint32_t rate = 0;
+    unsigned int planes = 0;        // planes in each packet, all of them go to the capture log
+    bool ignore_mute = false;
+    std::string name;
+    float gain = 1.0f;              // linear
+    AudioRing ring;
+};
+
 class WAVSource
 {
+public:
+    static constexpr int MAX_MIX_INPUTS = 4;    // audio source plus three additional sources
+
 protected:
-    // audio callback (and posssibly others) run in separate thread
-    // obs_source_remove_audio_capture_callback evidently flushes the callback
-    // so mutex must be recursive to avoid deadlock
-    std::recursive_timed_mutex m_mtx;
+    // update(), tick() and render() all run on the graphics thread and own the members below, except m_show and m_recorder
+    // audio callbacks only push into the lock-free rings of m_mix_inputs, with the config fixed in each input when it was connected,
+    // and into m_recorder (which locks) while a capture log is recorded,
+    // other threads (size queries, proc handlers) go through m_shared or obs_queue_task()
+    Snapshot<SharedConfig> m_shared;
 
     // obs sources
     obs_source_t *m_source = nullptr;               // our source
-    obs_weak_source_t *m_audio_source = nullptr;    // captured audio source
     std::string m_audio_source_name;
 
     // audio capture
@@ -399,17 +449,37 @@ protected:
     circlebuf m_capturebufs[2]{};
     uint32_t m_capture_channels = 0;        // audio input channels
     uint32_t m_output_channels = 0;         // fft output channels (*not* display channels)
-    bool m_output_bus_captured = false;     // do we have an active audio output callback? (via audio_output_connect())
+    uint32_t m_capture_rate = 0;            // sample rate of m_capturebufs (samples_per_sec / m_decimation)
+
+    // audio inputs, the audio source (or output bus) followed by any additional sources
+    // each is captured into its own ring, the mix is aligned by timestamp and fed to capture_packet() at tick time
+    MixInput m_mix_inputs[MAX_MIX_INPUTS];
+    int m_mix_count = 0;                    // configured inputs
+    AVXBufR m_mix_bufs[2];                  // mixed output for one block
+
+    // decimation ahead of the FFT when the upper cutoff allows it (spectrum mode)
+    int m_decimation = 1;
+    Decimator m_decimators[2];
+    AVXBufR m_decimate_buf;                 // decimator output for one block
 
     // 32-byte aligned buffers for FFT/AVX processing
     AVXBufR m_fft_input;
     AVXBufC m_fft_output;
     fftwf_plan m_fft_plan{};
+#ifdef ENABLE_X86_SIMD
+    RealFFT m_rfft;                         // in-tree FFT for power-of-two sizes (AVX2), replaces m_fft_plan when active
+#endif
     AVXBufR m_window_coefficients;
+    AVXBufC m_fft_windowed;                 // spectrum windowed in the frequency domain (see window_spectrum())
+    float m_spectral_taps[4] = {};          // cosine-sum window as a convolution of the spectrum, center tap first
+    int m_spectral_radius = 0;              // 0 if the window is applied in the time domain
     AVXBufR m_tsmooth_buf[2];               // last frames magnitudes
+    AlignedBuffer<uint16_t> m_tsmooth_half[2]; // same in binary16, scaled by HALF_HISTORY_SCALE (replaces m_tsmooth_buf when m_half_history is set)
     AVXBufR m_decibels[2];                  // dBFS, or audio sample buffer in meter mode
     size_t m_fft_size = 0;                  // number of fft elements, or audio samples in meter/waveform mode (not bytes, multiple of 16)
                                             // in meter/waveform mode m_fft_size is the size of the circular buffer in samples
+    size_t m_bin_start = 0;                 // first FFT bin held in m_decibels/m_tsmooth_buf (multiple of 8)
+    size_t m_bin_count = 0;                 // number of bins held, only the span reachable by the interpolation is processed
 
     // meter mode
     size_t m_meter_pos[2] = { 0, 0 };       // circular buffer position (per channel)
@@ -418,10 +488,48 @@ protected:
     bool m_meter_rms = false;               // RMS mode
     bool m_meter_mode = false;              // either meter or stepped meter display mode is selected
     int m_meter_ms = 100;                   // milliseconds of audio data to buffer
+    MeterBallistics m_ballistics_mode = MeterBallistics::NONE;
+    Ballistics m_ballistics;                // per-sample meter response, fed as the capture buffers are drained
 
     // waveform
     size_t m_waveform_samples = 0;          // maximum number of input samples to buffer in waveform mode
     size_t m_waveform_ts = 0;               // timestamp of next sample in nanoseconds
+    uint64_t m_capture_frames = 0;          // samples ever pushed to m_capturebufs[0], the newest one is m_capture_frames - 1
+
+    // oscilloscope (triggered waveform), positions count samples like m_capture_frames
+    bool m_scope = false;
+    float m_trigger_level = 0.0f;
+    float m_trigger_hysteresis = 0.02f;
+    bool m_trigger_armed = false;           // signal was below m_trigger_level - m_trigger_hysteresis since the last trigger
+    size_t m_scope_window = 0;              // samples shown
+    uint64_t m_scope_scan = 0;              // end of the searched audio
+    uint64_t m_scope_trigger = 0;           // start of the shown window
+
+    // vectorscope, m_vbuf is a ring of points written at tick time, positions count samples like m_capture_frames
+    bool m_vector_lines = false;
+    unsigned int m_vector_budget = 0;       // most points drawn, 0 for every sample
+    size_t m_vector_window = 0;             // samples shown and correlated
+    size_t m_vector_stride = 1;             // every n-th sample is drawn
+    size_t m_vector_capacity = 0;           // points in m_vbuf
+    size_t m_vector_head = 0;               // next point written
+    size_t m_vector_count = 0;              // valid points
+    vec3 *m_vector_points = nullptr;        // vertex data of m_vbuf
+    float m_vector_cx = 0.0f;
+    float m_vector_cy = 0.0f;
+    float m_vector_scale = 0.0f;            // pixels per unit of (L - R) and (L + R)
+    uint64_t m_vector_pos = 0;              // next sample
+    uint64_t m_corr_start = 0;              // first sample in the correlation sums
+    double m_corr_lr = 0.0;                 // running sums over the last m_vector_window samples
+    double m_corr_ll = 0.0;
+    double m_corr_rr = 0.0;
+    float m_correlation = 0.0f;
+    gs_vertbuffer_t *m_corr_vbuf = nullptr;
+
+    // filter bank analysis (bar modes), one bar per band instead of FFT bins
+    bool m_filterbank_enabled = false;
+    int m_octave_fraction = 3;              // bands per octave
+    FilterBank m_filterbank;
+    uint64_t m_filterbank_pos = 0;          // next sample, counts like m_capture_frames
 
     // video fps
     double m_fps = 0.0;
@@ -430,8 +538,9 @@ protected:
     unsigned int m_width = 800;
     unsigned int m_height = 225;
 
-    // show video source
-    bool m_show = true;
+    // show video source, show() and hide() may run on the UI thread
+    std::atomic<bool> m_show = true;
+    bool showing() const { return m_show.load(std::memory_order_relaxed); }
 
     // graph was silent last frame
     bool m_last_silent = false;
@@ -440,7 +549,7 @@ protected:
     int m_retries = 0;
     float m_next_retry = 0.0f;
 
-    uint64_t m_capture_ts = 0;  // timestamp of last audio callback in nanoseconds
+    uint64_t m_capture_ts = 0;  // timestamp of last captured packet in nanoseconds
     uint64_t m_audio_ts = 0;    // timestamp of the end of available audio in nanoseconds
     uint64_t m_tick_ts = 0;     // timestamp of last 'tick' in nanoseconds
     int64_t m_ts_offset = 0;    // audio sync offset in nanoseconds
@@ -465,9 +574,16 @@ protected:
     int m_range_middle = -20;
     int m_range_crest = -9;
     bool m_fast_peaks = false;
+    bool m_half_history = false;
+
+    // half precision history is stored 48 dB up, moving the subnormal range (and the point where smoothing
+    // stops decaying) below -130 dBFS, magnitudes over +48 dBFS clip
+    static constexpr float HALF_HISTORY_SCALE = 256.0f;
+    static constexpr float HALF_HISTORY_MAX = 65504.0f / HALF_HISTORY_SCALE;
     vec4 m_color_base{ {{1.0, 1.0, 1.0, 1.0}} };
     vec4 m_color_middle{ {{1.0, 1.0, 1.0, 1.0}} };
     vec4 m_color_crest{ {{1.0, 1.0, 1.0, 1.0}} };
+    vec4 m_color_ltas{ {{1.0, 1.0, 1.0, 0.5}} };
     float m_slope = 0.0f;
     bool m_log_scale = true;
     bool m_mirror_freq_axis = false;
@@ -509,6 +625,21 @@ protected:
     // lanczos filter
     Kernel<float> m_interp_kernel;
 
+    // curve level of detail, level n has ~m_width / 2^n points for sources drawn smaller than m_width pixels
+    // level 0 is m_interp_indices/m_interp_kernel/m_kernel/m_vbuf, entry 0 here is unused
+    static constexpr int CURVE_LODS = 6;
+    static constexpr unsigned int MIN_LOD_POINTS = 64;
+    struct CurveLod
+    {
+        std::vector<float> indices;
+        Kernel<float> interp_kernel;
+        Kernel<float> kernel;               // gaussian filter, radius scaled to the point spacing
+        gs_vertbuffer_t *vbuf = nullptr;
+        gs_texture_t *heights = nullptr;    // fill mode
+    };
+    CurveLod m_curve_lods[CURVE_LODS];
+    int m_num_lods = 1;
+
     // slope
     AVXBufR m_slope_modifiers;
 
@@ -523,6 +654,8 @@ protected:
     // render vars
     gs_effect_t *m_shader = nullptr;
     gs_vertbuffer_t *m_vbuf = nullptr;
+    bool m_curve_fill = false;          // filled curves drawn as a quad, the pixel shader reads the heights from a texture
+    gs_texture_t *m_heights = nullptr;  // one float per column, one row per channel
 
     // volume normalization
     float m_input_rms = 0.0f;
@@ -535,7 +668,41 @@ protected:
     // FFT window
     float m_window_sum = 1.0f;
 
+    // onset detection (spectrum mode)
+    bool m_onset_detection = false;
+    float m_onset_sensitivity = 0.5f;
+    OnsetDetector m_onset;
+    AVXBufR m_flux_prev[2];         // last frame's magnitudes (per capture channel)
+
+    // long-term average spectrum (curve mode)
+    bool m_ltas_enabled = false;
+    unsigned int m_ltas_seconds = 30;
+    LtasAccumulator m_ltas;
+    AVXBufR m_ltas_db[2];           // average in dBFS, same layout as m_decibels, with the roll-off of the live curve
+    bool m_ltas_stale = false;      // m_ltas_db lags m_ltas, refreshed when the curve is drawn
+
+    // rolling store of the analyzed spectra
+    bool m_history_enabled = false;
+    unsigned int m_history_minutes = 10;
+    uint32_t m_history_bytes = 1;   // bytes per sample
+    std::string m_history_path;
+    SpectrumHistory m_history;
+
+    // latency tracing
+    bool m_latency_overlay = false;
+    LatencyTracker m_latency;
+    uint64_t m_analyzed_ts = 0;     // end of the newest audio used by the last analysis, 0 once rendered
+    gs_vertbuffer_t *m_overlay_vbuf = nullptr;
+
+    // capture log recording/replay
+    CaptureRecorder m_recorder;
+    std::unique_ptr<CaptureReplay> m_replay;
+    uint64_t m_replay_clock = 0;    // log timestamp of the record being replayed
+    uint64_t m_replay_wall_ts = 0;  // wall time the replay was started at
+    double m_replay_speed = 1.0;    // playback rate, <= 0 to replay as fast as possible
+
     void create_vbuf();
+    gs_vertbuffer_t *create_curve_vbuf(unsigned int points); // curve vertices for one level of detail
     void free_vbuf();
     void create_shader();
     void free_shader();
@@ -545,16 +712,49 @@ protected:
     void recapture_audio();
     void release_audio_capture();
     bool check_audio_capture(float seconds); // check if capture is valid and retry if not
+    void capture_mix_inputs();
+    void configure_mix_input(MixInput& input);
+    void replay_mix_inputs();
+    void release_mix_inputs();
+    void mix_audio();                        // drain the input rings into the capture buffers
     void free_bufs();
 
     bool sync_rms_buffer();
 
+    void capture_packet(const audio_data *audio, bool muted); // append a packet to the capture buffers (graphics thread)
+    void process_audio(float seconds);                        // run the analysis for the current m_tick_ts
+    void detect_onsets(float flux);                           // feed the spectral flux of this tick and emit the onset signal
+    const fftwf_complex *window_spectrum(size_t first, size_t count); // FFT output with the window applied (if windowing in the frequency domain)
+    int set_spectral_window(std::initializer_list<float> coefficients); // returns the convolution radius
+    void tick_replay(float seconds);                          // feed the capture log into the pipeline
+    void start_replay(const char *path, double speed);
+    void stop_replay();
+    void write_onset_info(calldata_t *cd);
+    void write_latency_info(calldata_t *cd);
+    void write_correlation(calldata_t *cd);
+
+    uint64_t now_ns() const                 // current time, or the log time when replaying a capture log
+    {
+        return (m_replay != nullptr) ? m_replay_clock : os_gettime_ns();
+    }
+
     void init_interp(unsigned int sz);
+    void make_interp_indices(unsigned int sz, std::vector<float>& indices, float& lowbin, float& highbin) const;
+    Kernel<float> make_interp_kernel(const std::vector<float>& indices) const;
+    void init_curve_lods();
     void init_rolloff();
     void init_steps();
 
     void render_curve(gs_effect_t *effect);
+    void update_ltas_db();
+    float curve_footprint();                                                           // pixels the graph covers in the current render target
+    int select_lod(float footprint) const;
+    void map_curve(const AVXBufR *data, int lod, float& miny, unsigned int& minpos); // interpolate/filter 'data' into m_interp_bufs as y coordinates
+    void draw_curve(gs_technique_t *tech, int lod);                                    // draw m_interp_bufs
+    void draw_curve_fill(gs_technique_t *tech, gs_texture_t *heights, unsigned int points, float cpos, float channel_offset);
     void render_bars(gs_effect_t *effect);
+    void render_latency_overlay();
+    void render_vectorscope(gs_effect_t *effect);
 
     gs_technique_t *get_shader_tech();
     void set_shader_vars(float cpos, float miny, float minpos, float channel_offset, float border_top, float border_bottom);
@@ -564,6 +764,35 @@ protected:
     virtual void tick_spectrum(float) = 0;  // process audio data in frequency spectrum mode
     virtual void tick_meter(float) = 0;     // process audio data in meter mode
     virtual void tick_waveform(float) = 0;  // process audio data in waveform mode
+    virtual void tick_scope(float) = 0;     // process audio data in oscilloscope mode
+    virtual void tick_vectorscope(float) = 0; // process audio data in vectorscope mode
+    virtual void tick_filterbank(float) = 0;  // process audio data through the filter bank
+
+    // contiguous run of m_capturebufs[channel] starting 'index' samples from the front, 'count' is clamped to its length
+    const float *capture_run(unsigned int channel, size_t index, size_t& count) const
+    {
+        const auto& buf = m_capturebufs[channel];
+        const auto capacity = buf.capacity / sizeof(float);
+        const auto pos = ((buf.start_pos / sizeof(float)) + index) % capacity;
+        count = std::min(count, capacity - pos);
+        return (const float*)buf.data + pos;
+    }
+
+    // contiguous runs of the last 'frames' samples written to the meter buffers (at m_meter_pos[0])
+    template<typename F>
+    void for_each_meter_run(size_t frames, F&& func)
+    {
+        frames = std::min(frames, m_fft_size);
+        auto pos = (m_meter_pos[0] + m_fft_size - frames) % m_fft_size;
+        while(frames > 0)
+        {
+            const auto count = std::min(frames, m_fft_size - pos);
+            const float *planes[2] = { &m_decibels[0][pos], &m_decibels[(m_capture_channels > 1) ? 1 : 0][pos] };
+            func(planes, count);
+            pos = (pos + count) % m_fft_size;
+            frames -= count;
+        }
+    }
 
     int64_t get_audio_sync(uint64_t ts)     // get delta between end of available audio and given time in nanoseconds
     {
@@ -578,6 +807,11 @@ protected:
     static constexpr auto RETRY_DELAY = 2.0f;
     static constexpr uint64_t CAPTURE_TIMEOUT = 1000000ull * 500u;  // time in nanoseconds before audio capture is considered "lost" (500 ms)
     static constexpr uint64_t MAX_TS_DELTA = 1000000000ull * 16u;   // 16 seconds in ns
+    static constexpr int MAX_DECIMATION = 16;
+    static constexpr uint64_t MIX_MAX_LAG = 1000000ull * 100u;     // time in nanoseconds a mix input may fall behind before it is skipped (100 ms)
+    static constexpr int MAX_REPLAY_RECORDS = 64;                   // capture log records replayed per tick at most
+    static constexpr int CORRELATION_HEIGHT = 8;                    // correlation bar under the vectorscope
+    static constexpr int CORRELATION_GAP = 4;
 
     inline float dbfs(float mag)
     {
@@ -587,6 +821,12 @@ protected:
             return DB_MIN;
     }
 
+    // power gain of this frame's volume normalization, the long-term average is accumulated with it
+    inline float normalize_power_gain()
+    {
+        return m_normalize_volume ? std::pow(10.0f, std::min(m_volume_target - dbfs(m_input_rms), m_max_gain) / 10.0f) : 1.0f;
+    }
+
     inline float get_gravity(float seconds)
     {
         // FIXME: Scaling on this slider could probably use adjustment.
@@ -621,17 +861,33 @@ public:
 
     static void register_source();
 
-    // audio capture callback
-    void capture_audio(obs_source_t *source, const audio_data *audio, bool muted);
+    // audio capture callbacks, lock-free unless a capture log is being recorded
+    // they only touch the input and the recorder, never the rest of the source
+    // 'now' is the time the packet was received, the log time when replaying a capture log
+    void capture_mix_input(MixInput *input, const audio_data *audio, bool muted, uint64_t now);
+    void capture_output_bus(MixInput *input, const audio_data *audio, uint64_t now);
+
+    // capture log
+    void start_capture_log(const char *path);
+    void stop_capture_log();
+    void replay_capture_log(const char *path, double speed);
+    bool replaying() const { return m_replay != nullptr; } // graphics thread
 
-    // for capturing the final OBS audio output stream
-    void capture_output_bus(size_t mix_idx, const audio_data *audio);
+    // onset detection
+    void get_onset_info(calldata_t *cd);
+
+    // latency tracing
+    void get_latency_info(calldata_t *cd);
+
+    // vectorscope
+    void get_correlation(calldata_t *cd);
 
 #ifdef ENABLE_X86_SIMD
     // constants
     static const bool HAVE_AVX2;
     static const bool HAVE_AVX;
     static const bool HAVE_FMA3;
+    static const bool HAVE_F16C;
 #endif // ENABLE_X86_SIMD
 };
 
@@ -641,9 +897,16 @@ protected:
     void tick_spectrum(float seconds) override;
     void tick_meter(float seconds) override;
     void tick_waveform(float seconds) override;
+    void tick_scope(float seconds) override;
+    void tick_vectorscope(float seconds) override;
+    void tick_filterbank(float seconds) override;
 
     void update_input_rms() override;
 
+    void accumulate_ltas(size_t count); // add this frame's power to the long-term average
+    virtual size_t find_trigger(const float *samples, size_t count); // index of the last trigger or 'count', updates m_trigger_armed
+    virtual void vector_points(const float *left, const float *right, size_t count, vec3 *out); // vectorscope coordinates
+
 public:
     using WAVSource::WAVSource;
     ~WAVSourceGeneric() override = default;
@@ -659,6 +922,10 @@ protected:
 
     void update_input_rms() override;
 
+    void accumulate_ltas(size_t count);
+    size_t find_trigger(const float *samples, size_t count) override;
+    void vector_points(const float *left, const float *right, size_t count, vec3 *out) override;
+
 public:
     using WAVSourceGeneric::WAVSourceGeneric;
     ~WAVSourceAVX() override = default;
@@ -19,6 +19,7 @@
 #include "simd_helpers.hpp"
 #include <immintrin.h>
 #include <algorithm>
+#include <bit>
 #include <cstring>
 #include <cassert>
 
@@ -28,21 +29,24 @@
 // The only CPUs with FMA3 but not AVX2 are ancient AMD chips that prefer SSE code anyway.
 void WAVSourceAVX::tick_spectrum([[maybe_unused]] float seconds)
 {
-    //std::lock_guard lock(m_mtx); // now locked in tick()
-
     const auto bufsz = m_fft_size * sizeof(float);
-    const auto outsz = m_fft_size / 2;
+    const auto first = m_bin_start;
+    const auto outsz = m_bin_count;
     constexpr auto step = sizeof(__m256) / sizeof(float);
 
     const auto dtcapture = m_tick_ts - m_capture_ts;
 
-    if(!m_show || (dtcapture > CAPTURE_TIMEOUT))
+    if(!showing() || (dtcapture > CAPTURE_TIMEOUT))
     {
         if(m_last_silent)
             return;
         for(auto channel = 0u; channel < m_capture_channels; ++channel)
+        {
             if(m_tsmooth_buf[channel] != nullptr)
                 memset(m_tsmooth_buf[channel].get(), 0, outsz * sizeof(float));
+            if(m_tsmooth_half[channel] != nullptr)
+                memset(m_tsmooth_half[channel].get(), 0, outsz * sizeof(uint16_t));
+        }
         for(auto channel = 0; channel < (m_stereo ? 2 : 1); ++channel)
             for(size_t i = 0; i < outsz; ++i)
                 m_decibels[channel][i] = DB_MIN;
@@ -51,8 +55,9 @@ void WAVSourceAVX::tick_spectrum([[maybe_unused]] float seconds)
     }
 
     const int64_t dtaudio = get_audio_sync(m_tick_ts);
-    const size_t dtsize = ((dtaudio > 0) ? size_t(ns_to_audio_frames(m_audio_info.samples_per_sec, (uint64_t)dtaudio)) * sizeof(float) : 0) + bufsz;
+    const size_t dtsize = ((dtaudio > 0) ? size_t(ns_to_audio_frames(m_capture_rate, (uint64_t)dtaudio)) * sizeof(float) : 0) + bufsz;
     auto silent_channels = 0u;
+    auto flux = _mm256_setzero_ps();
     for(auto channel = 0u; channel < m_capture_channels; ++channel)
     {
         if(m_capturebufs[channel].size >= dtsize)
@@ -100,7 +105,8 @@ void WAVSourceAVX::tick_spectrum([[maybe_unused]] float seconds)
             }
         }
 
-        if(m_window_func != FFTWindow::NONE)
+        // time domain window, unless it is applied to the spectrum after the FFT
+        if((m_window_func != FFTWindow::NONE) && (m_spectral_radius == 0))
         {
             auto inbuf = m_fft_input.get();
             auto mulbuf = m_window_coefficients.get();
@@ -109,9 +115,14 @@ void WAVSourceAVX::tick_spectrum([[maybe_unused]] float seconds)
         }
 
         if(m_fft_plan != nullptr)
+        {
+            WAV_TRACE2(fft_start, this, m_fft_size);
             fftwf_execute(m_fft_plan);
+            WAV_TRACE2(fft_end, this, m_fft_size);
+        }
         else
             continue;
+        const auto spectrum = window_spectrum(first, outsz);
 
         constexpr auto shuffle_mask_r = 0 | (2 << 2) | (0 << 4) | (2 << 6);
         constexpr auto shuffle_mask_i = 1 | (3 << 2) | (1 << 4) | (3 << 6);
@@ -119,12 +130,15 @@ void WAVSourceAVX::tick_spectrum([[maybe_unused]] float seconds)
         const auto g = _mm256_set1_ps(get_gravity(seconds));
         const auto g2 = _mm256_sub_ps(_mm256_set1_ps(1.0), g);
         const bool slope = m_slope > 0.0f;
+        const auto half_scale = _mm256_set1_ps(HALF_HISTORY_SCALE);
+        const auto half_unscale = _mm256_set1_ps(1.0f / HALF_HISTORY_SCALE);
+        const auto half_max = _mm256_set1_ps(HALF_HISTORY_MAX);
         for(size_t i = 0; i < outsz; i += step)
         {
             // load 8 real/imaginary pairs and group the r/i components in the low/high halves
             // de-interleaving 256-bit float vectors is nigh impossible without AVX2, so we'll
             // use 128-bit vectors and merge them, but i question if this is better than a 128-bit loop
-            const float *buf = &m_fft_output[i][0];
+            const float *buf = &spectrum[first + i][0];
             auto chunk1 = _mm_load_ps(buf);
             auto chunk2 = _mm_load_ps(&buf[4]);
             auto rvec = _mm256_castps128_ps256(_mm_shuffle_ps(chunk1, chunk2, shuffle_mask_r)); // group octwords
@@ -137,29 +151,46 @@ void WAVSourceAVX::tick_spectrum([[maybe_unused]] float seconds)
             auto mag = _mm256_sqrt_ps(_mm256_fmadd_ps(ivec, ivec, _mm256_mul_ps(rvec, rvec)));
             mag = _mm256_mul_ps(mag, mag_coefficient);
 
+            // half-wave rectified spectral flux for onset detection (before slope and smoothing)
+            if(m_onset_detection)
+            {
+                auto prev = _mm256_load_ps(&m_flux_prev[channel][i]);
+                flux = _mm256_add_ps(flux, _mm256_max_ps(_mm256_sub_ps(mag, prev), _mm256_setzero_ps()));
+                _mm256_store_ps(&m_flux_prev[channel][i], mag);
+            }
+
             if(slope)
-                mag = _mm256_mul_ps(mag, _mm256_load_ps(&m_slope_modifiers[i]));
+                mag = _mm256_mul_ps(mag, _mm256_load_ps(&m_slope_modifiers[first + i]));
 
             if(m_tsmoothing != TSmoothingMode::NONE)
             {
-                auto oldval = _mm256_load_ps(&m_tsmooth_buf[channel][i]);
+                auto oldval = m_half_history ? _mm256_mul_ps(_mm256_cvtph_ps(_mm_load_si128((const __m128i*)&m_tsmooth_half[channel][i])), half_unscale) : _mm256_load_ps(&m_tsmooth_buf[channel][i]);
                 if(m_fast_peaks)
                     oldval = _mm256_max_ps(mag, oldval);
 
                 mag = _mm256_fmadd_ps(g, oldval, _mm256_mul_ps(g2, mag));
-                _mm256_store_ps(&m_tsmooth_buf[channel][i], mag);
+                if(m_half_history)
+                    _mm_store_si128((__m128i*)&m_tsmooth_half[channel][i], _mm256_cvtps_ph(_mm256_mul_ps(_mm256_min_ps(mag, half_max), half_scale), _MM_FROUND_TO_NEAREST_INT));
+                else
+                    _mm256_store_ps(&m_tsmooth_buf[channel][i], mag);
             }
 
             _mm256_store_ps(&m_decibels[channel][i], mag);
         }
     }
 
+    if(m_onset_detection)
+        detect_onsets(horizontal_sum(flux) / (float)(outsz * m_capture_channels));
+
     if(m_last_silent)
         return;
 
     if(m_output_channels > m_capture_channels)
         memcpy(m_decibels[1].get(), m_decibels[0].get(), outsz * sizeof(float));
 
+    if(m_ltas_enabled)
+        accumulate_ltas(outsz);
+
     if(m_stereo)
     {
         for(auto channel = 0; channel < 2; ++channel)
@@ -192,7 +223,7 @@ void WAVSourceAVX::tick_spectrum([[maybe_unused]] float seconds)
         {
             for(size_t i = 0; i < outsz; i += step)
             {
-                auto val = _mm256_sub_ps(_mm256_load_ps(&m_decibels[channel][i]), _mm256_load_ps(&m_rolloff_modifiers[i]));
+                auto val = _mm256_sub_ps(_mm256_load_ps(&m_decibels[channel][i]), _mm256_load_ps(&m_rolloff_modifiers[first + i]));
                 _mm256_store_ps(&m_decibels[channel][i], _mm256_max_ps(val, dbmin));
             }
         }
@@ -217,6 +248,7 @@ void WAVSourceAVX::tick_meter([[maybe_unused]] float seconds)
             i = 0.0f;
         for(auto& i : m_meter_val)
             i = DB_MIN;
+        m_ballistics.reset();
         m_last_silent = true;
         return;
     }
@@ -225,6 +257,7 @@ void WAVSourceAVX::tick_meter([[maybe_unused]] float seconds)
     const size_t dtsize = (dtaudio > 0) ? size_t(ns_to_audio_frames(m_audio_info.samples_per_sec, (uint64_t)dtaudio)) * sizeof(float) : 0;
 
     // repurpose m_decibels as circular buffer for sample data
+    const auto drained = (m_capturebufs[0].size > dtsize) ? (m_capturebufs[0].size - dtsize) / sizeof(float) : 0;
     for(auto channel = 0u; channel < m_capture_channels; ++channel)
     {
         while(m_capturebufs[channel].size > dtsize)
@@ -244,11 +277,22 @@ void WAVSourceAVX::tick_meter([[maybe_unused]] float seconds)
         }
     }
 
-    if(!m_show)
+    // ballistics see every new sample
+    if(m_ballistics_mode != MeterBallistics::NONE)
+        for_each_meter_run(drained, [this](const float *const *planes, size_t count) { m_ballistics.process_sse(planes, m_capture_channels, count); });
+
+    if(!showing())
         return;
 
     for(auto channel = 0u; channel < m_capture_channels; ++channel)
     {
+        if(m_ballistics_mode != MeterBallistics::NONE)
+        {
+            m_meter_buf[channel] = m_ballistics.value(channel);
+            m_meter_val[channel] = dbfs(m_meter_buf[channel]);
+            continue;
+        }
+
         float out = 0.0f;
         constexpr auto step = (sizeof(__m256) / sizeof(float)) * 2; // buffer size is 64-byte multiple
         constexpr auto halfstep = step / 2;
@@ -302,6 +346,65 @@ void WAVSourceAVX::tick_meter([[maybe_unused]] float seconds)
     m_last_silent = (silent_channels >= m_capture_channels);
 }
 
+size_t WAVSourceAVX::find_trigger(const float *samples, size_t count)
+{
+    // compare 8 samples at once, the masks are only walked where the trigger state changes
+    const auto low = _mm256_set1_ps(m_trigger_level - m_trigger_hysteresis);
+    const auto high = _mm256_set1_ps(m_trigger_level);
+    auto armed = m_trigger_armed;
+    auto found = count;
+    size_t i = 0;
+    for(; (i + 8) <= count; i += 8)
+    {
+        const auto chunk = _mm256_loadu_ps(&samples[i]);
+        const auto below = (unsigned int)_mm256_movemask_ps(_mm256_cmp_ps(chunk, low, _CMP_LT_OQ));
+        const auto above = (unsigned int)_mm256_movemask_ps(_mm256_cmp_ps(chunk, high, _CMP_GE_OQ));
+        for(auto pos = 0; pos < 8; ++pos)
+        {
+            const auto mask = (armed ? above : below) >> pos;
+            if(mask == 0)
+                break;
+            pos += std::countr_zero(mask);
+            if(armed)
+                found = i + pos;
+            armed = !armed;
+        }
+    }
+
+    m_trigger_armed = armed;
+    const auto tail = WAVSourceGeneric::find_trigger(&samples[i], count - i);
+    return (tail < (count - i)) ? (i + tail) : found;
+}
+
+void WAVSourceAVX::vector_points(const float *left, const float *right, size_t count, vec3 *out)
+{
+    // 8 points per step, interleaved to (x, y, 0, 0) in registers
+    const auto cx = _mm256_set1_ps(m_vector_cx);
+    const auto cy = _mm256_set1_ps(m_vector_cy);
+    const auto scale = _mm256_set1_ps(m_vector_scale);
+    const auto zero = _mm256_setzero_pd();
+    size_t i = 0;
+    for(; (i + 8) <= count; i += 8)
+    {
+        const auto l = _mm256_loadu_ps(&left[i]);
+        const auto r = _mm256_loadu_ps(&right[i]);
+        const auto x = _mm256_add_ps(cx, _mm256_mul_ps(_mm256_sub_ps(l, r), scale));
+        const auto y = _mm256_sub_ps(cy, _mm256_mul_ps(_mm256_add_ps(l, r), scale));
+        const auto xy_lo = _mm256_castps_pd(_mm256_unpacklo_ps(x, y));     // 0 1 | 4 5
+        const auto xy_hi = _mm256_castps_pd(_mm256_unpackhi_ps(x, y));     // 2 3 | 6 7
+        const auto p04 = _mm256_castpd_ps(_mm256_unpacklo_pd(xy_lo, zero));
+        const auto p15 = _mm256_castpd_ps(_mm256_unpackhi_pd(xy_lo, zero));
+        const auto p26 = _mm256_castpd_ps(_mm256_unpacklo_pd(xy_hi, zero));
+        const auto p37 = _mm256_castpd_ps(_mm256_unpackhi_pd(xy_hi, zero));
+        auto dst = reinterpret_cast<float*>(&out[i]);
+        _mm256_storeu_ps(dst, _mm256_permute2f128_ps(p04, p15, 0x20));
+        _mm256_storeu_ps(dst + 8, _mm256_permute2f128_ps(p26, p37, 0x20));
+        _mm256_storeu_ps(dst + 16, _mm256_permute2f128_ps(p04, p15, 0x31));
+        _mm256_storeu_ps(dst + 24, _mm256_permute2f128_ps(p26, p37, 0x31));
+    }
+    WAVSourceGeneric::vector_points(&left[i], &right[i], count - i, &out[i]);
+}
+
 void WAVSourceAVX::update_input_rms()
 {
     assert(m_normalize_volume);
@@ -320,3 +423,33 @@ void WAVSourceAVX::update_input_rms()
     }
     m_input_rms = std::sqrt(horizontal_sum(_mm256_add_ps(sum1, sum2)) / m_input_rms_size);
 }
+
+void WAVSourceAVX::accumulate_ltas(size_t count)
+{
+    // scaled by the volume normalization that follows, as amplitude so one multiply covers it
+    constexpr auto step = sizeof(__m256) / sizeof(float);
+    const auto gain = _mm256_set1_ps(std::sqrt(normalize_power_gain()));
+    if(m_stereo || (m_capture_channels < 2))
+    {
+        for(auto channel = 0; channel < (m_stereo ? 2 : 1); ++channel)
+        {
+            auto sums = m_ltas.partial(channel);
+            for(size_t i = 0; i < count; i += step)
+            {
+                auto mag = _mm256_mul_ps(_mm256_load_ps(&m_decibels[channel][i]), gain);
+                _mm256_store_ps(&sums[i], _mm256_fmadd_ps(mag, mag, _mm256_load_ps(&sums[i])));
+            }
+        }
+    }
+    else
+    {
+        const auto half = _mm256_mul_ps(_mm256_set1_ps(0.5f), gain);
+        auto sums = m_ltas.partial(0);
+        for(size_t i = 0; i < count; i += step)
+        {
+            auto mag = _mm256_mul_ps(_mm256_add_ps(_mm256_load_ps(&m_decibels[0][i]), _mm256_load_ps(&m_decibels[1][i])), half);
+            _mm256_store_ps(&sums[i], _mm256_fmadd_ps(mag, mag, _mm256_load_ps(&sums[i])));
+        }
+    }
+    m_ltas.commit();
+}
@@ -16,6 +16,7 @@
 */
 
 #include "source.hpp"
+#include "simd_helpers.hpp"
 #include <immintrin.h>
 #include <algorithm>
 #include <cstring>
@@ -23,23 +24,26 @@
 
 void WAVSourceAVX2::tick_spectrum([[maybe_unused]] float seconds)
 {
-    //std::lock_guard lock(m_mtx); // now locked in tick()
-
     const auto bufsz = m_fft_size * sizeof(float);
-    const auto outsz = m_fft_size / 2; // discard bins at nyquist and above
+    const auto first = m_bin_start; // only the bins the display can reach are processed
+    const auto outsz = m_bin_count; // discard bins at nyquist and above
     constexpr auto step = sizeof(__m256) / sizeof(float);
 
     const auto dtcapture = m_tick_ts - m_capture_ts;
 
     // reset and stop processing when source is not being displayed
     // or we haven't received audio data for more than the timeout value
-    if(!m_show || (dtcapture > CAPTURE_TIMEOUT))
+    if(!showing() || (dtcapture > CAPTURE_TIMEOUT))
     {
         if(m_last_silent)
             return;
         for(auto channel = 0u; channel < m_capture_channels; ++channel)
+        {
             if(m_tsmooth_buf[channel] != nullptr)
                 memset(m_tsmooth_buf[channel].get(), 0, outsz * sizeof(float));
+            if(m_tsmooth_half[channel] != nullptr)
+                memset(m_tsmooth_half[channel].get(), 0, outsz * sizeof(uint16_t));
+        }
         for(auto channel = 0; channel < (m_stereo ? 2 : 1); ++channel)
             for(size_t i = 0; i < outsz; ++i)
                 m_decibels[channel][i] = DB_MIN;
@@ -48,8 +52,9 @@ void WAVSourceAVX2::tick_spectrum([[maybe_unused]] float seconds)
     }
 
     const int64_t dtaudio = get_audio_sync(m_tick_ts);
-    const size_t dtsize = ((dtaudio > 0) ? size_t(ns_to_audio_frames(m_audio_info.samples_per_sec, (uint64_t)dtaudio)) * sizeof(float) : 0) + bufsz;
+    const size_t dtsize = ((dtaudio > 0) ? size_t(ns_to_audio_frames(m_capture_rate, (uint64_t)dtaudio)) * sizeof(float) : 0) + bufsz;
     auto silent_channels = 0u;
+    auto flux = _mm256_setzero_ps();
     for(auto channel = 0u; channel < m_capture_channels; ++channel)
     {
         // get captured audio
@@ -100,8 +105,8 @@ void WAVSourceAVX2::tick_spectrum([[maybe_unused]] float seconds)
             }
         }
 
-        // window function
-        if(m_window_func != FFTWindow::NONE)
+        // window function (fused into the in-tree FFT, or applied to the spectrum afterwards)
+        if((m_window_func != FFTWindow::NONE) && (m_spectral_radius == 0) && !m_rfft)
         {
             auto inbuf = m_fft_input.get();
             auto mulbuf = m_window_coefficients.get();
@@ -110,8 +115,22 @@ void WAVSourceAVX2::tick_spectrum([[maybe_unused]] float seconds)
         }
 
         // FFT
-        if(m_fft_plan != nullptr)
+        const fftwf_complex *spectrum = nullptr;
+        if(m_rfft)
+        {
+            // writes the normalized magnitudes straight to the output buffer
+            WAV_TRACE2(fft_start, this, m_fft_size);
+            auto window = (m_window_func != FFTWindow::NONE) ? m_window_coefficients.get() : nullptr;
+            m_rfft.magnitudes(m_fft_input.get(), window, 2.0f / m_window_sum, m_decibels[channel].get(), first, outsz);
+            WAV_TRACE2(fft_end, this, m_fft_size);
+        }
+        else if(m_fft_plan != nullptr)
+        {
+            WAV_TRACE2(fft_start, this, m_fft_size);
             fftwf_execute(m_fft_plan);
+            WAV_TRACE2(fft_end, this, m_fft_size);
+            spectrum = window_spectrum(first, outsz);
+        }
         else
             continue;
 
@@ -121,50 +140,76 @@ void WAVSourceAVX2::tick_spectrum([[maybe_unused]] float seconds)
         const auto g = _mm256_set1_ps(get_gravity(seconds));
         const auto g2 = _mm256_sub_ps(_mm256_set1_ps(1.0), g); // 1 - gravity
         const bool slope = m_slope > 0.0f;
+        const auto half_scale = _mm256_set1_ps(HALF_HISTORY_SCALE);
+        const auto half_unscale = _mm256_set1_ps(1.0f / HALF_HISTORY_SCALE);
+        const auto half_max = _mm256_set1_ps(HALF_HISTORY_MAX);
         for(size_t i = 0; i < outsz; i += step)
         {
-            // this *should* be faster than 2x vgatherxxx instructions
-            // load 8 real/imaginary pairs and group the r/i components in the low/high halves
-            const float *buf = &m_fft_output[i][0]; // first element of complex (float[2])
-            auto chunk1 = _mm256_permutevar8x32_ps(_mm256_load_ps(buf), shuffle_mask);
-            auto chunk2 = _mm256_permutevar8x32_ps(_mm256_load_ps(&buf[step]), shuffle_mask);
-
-            // pack the real and imaginary components into separate vectors
-            auto rvec = _mm256_insertf128_ps(chunk1, _mm256_castps256_ps128(chunk2), 1); // faster than vperm2f128 on AMD until Zen2
-            auto ivec = _mm256_permute2f128_ps(chunk1, chunk2, 1 | (3 << 4)); // no choice here (without using more instructions)
+            __m256 mag;
+            if(m_rfft)
+                mag = _mm256_load_ps(&m_decibels[channel][i]); // already normalized
+            else
+            {
+                // this *should* be faster than 2x vgatherxxx instructions
+                // load 8 real/imaginary pairs and group the r/i components in the low/high halves
+                const float *buf = &spectrum[first + i][0]; // first element of complex (float[2])
+                auto chunk1 = _mm256_permutevar8x32_ps(_mm256_load_ps(buf), shuffle_mask);
+                auto chunk2 = _mm256_permutevar8x32_ps(_mm256_load_ps(&buf[step]), shuffle_mask);
+
+                // pack the real and imaginary components into separate vectors
+                auto rvec = _mm256_insertf128_ps(chunk1, _mm256_castps256_ps128(chunk2), 1); // faster than vperm2f128 on AMD until Zen2
+                auto ivec = _mm256_permute2f128_ps(chunk1, chunk2, 1 | (3 << 4)); // no choice here (without using more instructions)
+
+                // calculate normalized magnitude
+                // 2 * magnitude / window
+                mag = _mm256_sqrt_ps(_mm256_fmadd_ps(ivec, ivec, _mm256_mul_ps(rvec, rvec))); // magnitude sqrt(r^2 + i^2)
+                mag = _mm256_mul_ps(mag, mag_coefficient); // 2 * magnitude / window with precomputed quotient
+            }
 
-            // calculate normalized magnitude
-            // 2 * magnitude / window
-            auto mag = _mm256_sqrt_ps(_mm256_fmadd_ps(ivec, ivec, _mm256_mul_ps(rvec, rvec))); // magnitude sqrt(r^2 + i^2)
-            mag = _mm256_mul_ps(mag, mag_coefficient); // 2 * magnitude / window with precomputed quotient
+            // half-wave rectified spectral flux for onset detection (before slope and smoothing)
+            if(m_onset_detection)
+            {
+                auto prev = _mm256_load_ps(&m_flux_prev[channel][i]);
+                flux = _mm256_add_ps(flux, _mm256_max_ps(_mm256_sub_ps(mag, prev), _mm256_setzero_ps()));
+                _mm256_store_ps(&m_flux_prev[channel][i], mag);
+            }
 
             // boost high frequencies
             if(slope)
-                mag = _mm256_mul_ps(mag, _mm256_load_ps(&m_slope_modifiers[i]));
+                mag = _mm256_mul_ps(mag, _mm256_load_ps(&m_slope_modifiers[first + i]));
 
             // time domain smoothing
             if(m_tsmoothing != TSmoothingMode::NONE)
             {
-                auto oldval = _mm256_load_ps(&m_tsmooth_buf[channel][i]);
+                auto oldval = m_half_history ? _mm256_mul_ps(_mm256_cvtph_ps(_mm_load_si128((const __m128i*)&m_tsmooth_half[channel][i])), half_unscale) : _mm256_load_ps(&m_tsmooth_buf[channel][i]);
                 // take new values immediately if larger
                 if(m_fast_peaks)
                     oldval = _mm256_max_ps(mag, oldval);
 
                 // (gravity * oldval) + ((1 - gravity) * newval)
                 mag = _mm256_fmadd_ps(g, oldval, _mm256_mul_ps(g2, mag));
-                _mm256_store_ps(&m_tsmooth_buf[channel][i], mag);
+                if(m_half_history)
+                    _mm_store_si128((__m128i*)&m_tsmooth_half[channel][i], _mm256_cvtps_ph(_mm256_mul_ps(_mm256_min_ps(mag, half_max), half_scale), _MM_FROUND_TO_NEAREST_INT));
+                else
+                    _mm256_store_ps(&m_tsmooth_buf[channel][i], mag);
             }
 
             _mm256_store_ps(&m_decibels[channel][i], mag); // end of the line for AVX
         }
     }
 
+    if(m_onset_detection)
+        detect_onsets(horizontal_sum(flux) / (float)(outsz * m_capture_channels));
+
     if(m_last_silent)
         return;
 
     if(m_output_channels > m_capture_channels)
         memcpy(m_decibels[1].get(), m_decibels[0].get(), outsz * sizeof(float));
 
+    if(m_ltas_enabled)
+        accumulate_ltas(outsz);
+
     // dBFS conversion
     // 20 * log(2 * magnitude / window)
     if(m_stereo)
@@ -201,7 +246,7 @@ void WAVSourceAVX2::tick_spectrum([[maybe_unused]] float seconds)
         {
             for(size_t i = 0; i < outsz; i += step)
             {
-                auto val = _mm256_sub_ps(_mm256_load_ps(&m_decibels[channel][i]), _mm256_load_ps(&m_rolloff_modifiers[i]));
+                auto val = _mm256_sub_ps(_mm256_load_ps(&m_decibels[channel][i]), _mm256_load_ps(&m_rolloff_modifiers[first + i]));
                 _mm256_store_ps(&m_decibels[channel][i], _mm256_max_ps(val, dbmin));
             }
         }
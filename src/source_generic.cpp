@@ -25,21 +25,24 @@
 // see comments of WAVSourceAVX2 and WAVSourceAVX
 void WAVSourceGeneric::tick_spectrum([[maybe_unused]] float seconds)
 {
-    //std::lock_guard lock(m_mtx); // now locked in tick()
-
     const auto bufsz = m_fft_size * sizeof(float);
-    const auto outsz = m_fft_size / 2;
+    const auto first = m_bin_start;
+    const auto outsz = m_bin_count;
     constexpr auto step = 1;
 
     const auto dtcapture = m_tick_ts - m_capture_ts;
 
-    if(!m_show || (dtcapture > CAPTURE_TIMEOUT))
+    if(!showing() || (dtcapture > CAPTURE_TIMEOUT))
     {
         if(m_last_silent)
             return;
         for(auto channel = 0u; channel < m_capture_channels; ++channel)
+        {
             if(m_tsmooth_buf[channel] != nullptr)
                 memset(m_tsmooth_buf[channel].get(), 0, outsz * sizeof(float));
+            if(m_tsmooth_half[channel] != nullptr)
+                memset(m_tsmooth_half[channel].get(), 0, outsz * sizeof(uint16_t));
+        }
         for(auto channel = 0; channel < (m_stereo ? 2 : 1); ++channel)
             for(size_t i = 0; i < outsz; ++i)
                 m_decibels[channel][i] = DB_MIN;
@@ -48,8 +51,9 @@ void WAVSourceGeneric::tick_spectrum([[maybe_unused]] float seconds)
     }
 
     const int64_t dtaudio = get_audio_sync(m_tick_ts);
-    const size_t dtsize = ((dtaudio > 0) ? size_t(ns_to_audio_frames(m_audio_info.samples_per_sec, (uint64_t)dtaudio)) * sizeof(float) : 0) + bufsz;
+    const size_t dtsize = ((dtaudio > 0) ? size_t(ns_to_audio_frames(m_capture_rate, (uint64_t)dtaudio)) * sizeof(float) : 0) + bufsz;
     auto silent_channels = 0u;
+    auto flux = 0.0f;
     for(auto channel = 0u; channel < m_capture_channels; ++channel)
     {
         if(m_capturebufs[channel].size >= dtsize)
@@ -94,7 +98,8 @@ void WAVSourceGeneric::tick_spectrum([[maybe_unused]] float seconds)
             }
         }
 
-        if(m_window_func != FFTWindow::NONE)
+        // time domain window, unless it is applied to the spectrum after the FFT
+        if((m_window_func != FFTWindow::NONE) && (m_spectral_radius == 0))
         {
             auto inbuf = m_fft_input.get();
             auto mulbuf = m_window_coefficients.get();
@@ -103,9 +108,14 @@ void WAVSourceGeneric::tick_spectrum([[maybe_unused]] float seconds)
         }
 
         if(m_fft_plan != nullptr)
+        {
+            WAV_TRACE2(fft_start, this, m_fft_size);
             fftwf_execute(m_fft_plan);
+            WAV_TRACE2(fft_end, this, m_fft_size);
+        }
         else
             continue;
+        const auto spectrum = window_spectrum(first, outsz);
 
         const auto mag_coefficient = 2.0f / m_window_sum;
         const auto g = get_gravity(seconds);
@@ -113,34 +123,49 @@ void WAVSourceGeneric::tick_spectrum([[maybe_unused]] float seconds)
         const bool slope = m_slope > 0.0f;
         for(size_t i = 0; i < outsz; i += step)
         {
-            auto real = m_fft_output[i][0];
-            auto imag = m_fft_output[i][1];
+            auto real = spectrum[first + i][0];
+            auto imag = spectrum[first + i][1];
 
             auto mag = std::hypot(real, imag) * mag_coefficient;
 
+            if(m_onset_detection)
+            {
+                flux += std::max(mag - m_flux_prev[channel][i], 0.0f);
+                m_flux_prev[channel][i] = mag;
+            }
+
             if(slope)
-                mag *= m_slope_modifiers[i];
+                mag *= m_slope_modifiers[first + i];
 
             if(m_tsmoothing != TSmoothingMode::NONE)
             {
-                auto oldval = m_tsmooth_buf[channel][i];
+                auto oldval = m_half_history ? half_to_float(m_tsmooth_half[channel][i]) * (1.0f / HALF_HISTORY_SCALE) : m_tsmooth_buf[channel][i];
                 if(m_fast_peaks)
                     oldval = std::max(mag, oldval);
 
                 mag = (g * oldval) + (g2 * mag);
-                m_tsmooth_buf[channel][i] = mag;
+                if(m_half_history)
+                    m_tsmooth_half[channel][i] = float_to_half(std::min(mag, HALF_HISTORY_MAX) * HALF_HISTORY_SCALE);
+                else
+                    m_tsmooth_buf[channel][i] = mag;
             }
 
             m_decibels[channel][i] = mag;
         }
     }
 
+    if(m_onset_detection)
+        detect_onsets(flux / (float)(outsz * m_capture_channels));
+
     if(m_last_silent)
         return;
 
     if(m_output_channels > m_capture_channels)
         memcpy(m_decibels[1].get(), m_decibels[0].get(), outsz * sizeof(float));
 
+    if(m_ltas_enabled)
+        accumulate_ltas(outsz);
+
     if(m_stereo)
     {
         for(auto channel = 0; channel < 2; ++channel)
@@ -162,7 +187,7 @@ void WAVSourceGeneric::tick_spectrum([[maybe_unused]] float seconds)
     {
         const auto volume_compensation = std::min(m_volume_target - dbfs(m_input_rms), m_max_gain);
         for(auto channel = 0; channel < (m_stereo ? 2 : 1); ++channel)
-            for(size_t i = 1; i < outsz; ++i)
+            for(size_t i = (first > 0) ? 0 : 1; i < outsz; ++i)
                 m_decibels[channel][i] += volume_compensation;
     }
 
@@ -170,9 +195,9 @@ void WAVSourceGeneric::tick_spectrum([[maybe_unused]] float seconds)
     {
         for(auto channel = 0; channel < (m_stereo ? 2 : 1); ++channel)
         {
-            for(size_t i = 1; i < outsz; ++i)
+            for(size_t i = (first > 0) ? 0 : 1; i < outsz; ++i)
             {
-                auto val = m_decibels[channel][i] - m_rolloff_modifiers[i];
+                auto val = m_decibels[channel][i] - m_rolloff_modifiers[first + i];
                 m_decibels[channel][i] = std::max(val, DB_MIN);
             }
         }
@@ -194,6 +219,7 @@ void WAVSourceGeneric::tick_meter([[maybe_unused]] float seconds)
             i = 0.0f;
         for(auto& i : m_meter_val)
             i = DB_MIN;
+        m_ballistics.reset();
         m_last_silent = true;
         return;
     }
@@ -202,6 +228,7 @@ void WAVSourceGeneric::tick_meter([[maybe_unused]] float seconds)
     const int64_t dtaudio = get_audio_sync(m_tick_ts);
     const size_t dtsize = (dtaudio > 0) ? size_t(ns_to_audio_frames(m_audio_info.samples_per_sec, (uint64_t)dtaudio)) * sizeof(float) : 0;
 
+    const auto drained = (m_capturebufs[0].size > dtsize) ? (m_capturebufs[0].size - dtsize) / sizeof(float) : 0;
     for(auto channel = 0u; channel < m_capture_channels; ++channel)
     {
         while(m_capturebufs[channel].size > dtsize)
@@ -221,7 +248,11 @@ void WAVSourceGeneric::tick_meter([[maybe_unused]] float seconds)
         }
     }
 
-    if(!m_show)
+    // ballistics see every new sample
+    if(m_ballistics_mode != MeterBallistics::NONE)
+        for_each_meter_run(drained, [this](const float *const *planes, size_t count) { m_ballistics.process(planes, m_capture_channels, count); });
+
+    if(!showing())
     {
         for(auto& i : m_meter_buf)
             i = 0.0f;
@@ -233,6 +264,13 @@ void WAVSourceGeneric::tick_meter([[maybe_unused]] float seconds)
 
     for(auto channel = 0u; channel < m_capture_channels; ++channel)
     {
+        if(m_ballistics_mode != MeterBallistics::NONE)
+        {
+            m_meter_buf[channel] = m_ballistics.value(channel);
+            m_meter_val[channel] = dbfs(m_meter_buf[channel]);
+            continue;
+        }
+
         float out = 0.0f;
         if(m_meter_rms)
         {
@@ -276,7 +314,7 @@ void WAVSourceGeneric::tick_waveform([[maybe_unused]] float seconds)
 
     const auto dtcapture = m_tick_ts - m_capture_ts;
 
-    if(!m_show || (dtcapture > CAPTURE_TIMEOUT))
+    if(!showing() || (dtcapture > CAPTURE_TIMEOUT))
     {
         if(m_last_silent)
             return;
@@ -301,8 +339,6 @@ void WAVSourceGeneric::tick_waveform([[maybe_unused]] float seconds)
     {
         if(m_capturebufs[channel].size > max_size)
             circlebuf_pop_front(&m_capturebufs[channel], nullptr, m_capturebufs[channel].size - max_size);
-        if(m_interp_bufs[2].size() < (m_capturebufs[channel].size / sizeof(float)))
-            m_interp_bufs[2].resize(m_capturebufs[channel].size / sizeof(float)); // FIXME: temporary hack
         const auto consume = m_capturebufs[channel].size - reserve;
         const auto total_samples = m_capturebufs[channel].size / sizeof(float);
         const auto reserve_samples = reserve / sizeof(float);
@@ -319,7 +355,7 @@ void WAVSourceGeneric::tick_waveform([[maybe_unused]] float seconds)
             m_waveform_ts = start_ts; // catch up if we're falling behind
         if((m_waveform_ts > stop_ts) && ((m_waveform_ts - stop_ts) > step_ns))
             m_waveform_ts = start_ts; // fix desync
-        circlebuf_pop_front(&m_capturebufs[channel], m_interp_bufs[2].data(), consume);
+        // sample straight from the circular buffer before consuming it
         for(size_t i = 0; i < outsz; ++i)
         {
             const auto ts = m_waveform_ts + (i * step_ns);
@@ -329,8 +365,9 @@ void WAVSourceGeneric::tick_waveform([[maybe_unused]] float seconds)
                 break; // rollover
             // TODO: interpolation
             const auto index = std::clamp((uint64_t)ns_to_audio_frames(m_audio_info.samples_per_sec, m_audio_ts - ts), (uint64_t)reserve_samples + 1u, (uint64_t)total_samples);
-            m_decibels[channel][counts[channel]++] = m_interp_bufs[2][total_samples - index];
+            m_decibels[channel][counts[channel]++] = *(const float*)circlebuf_data(&m_capturebufs[channel], (total_samples - index) * sizeof(float));
         }
+        circlebuf_pop_front(&m_capturebufs[channel], nullptr, consume);
         std::rotate(&m_decibels[channel][0], &m_decibels[channel][counts[channel]], &m_decibels[channel][outsz]);
 
         bool silent = true;
@@ -389,6 +426,356 @@ void WAVSourceGeneric::tick_waveform([[maybe_unused]] float seconds)
     }
 }
 
+void WAVSourceGeneric::tick_scope([[maybe_unused]] float seconds)
+{
+    const auto outsz = m_fft_size;
+    const auto channels = m_stereo ? 2u : 1u;
+    const auto dtcapture = m_tick_ts - m_capture_ts;
+
+    if(!showing() || (dtcapture > CAPTURE_TIMEOUT))
+    {
+        if(m_last_silent)
+            return;
+        for(auto channel = 0u; channel < channels; ++channel)
+            std::fill(&m_decibels[channel][0], &m_decibels[channel][outsz], 0.0f);
+        m_last_silent = true;
+        return;
+    }
+
+    // audio held back for sync is neither searched nor shown, a trigger needs a whole window after it
+    const int64_t dtaudio = get_audio_sync(m_tick_ts);
+    const size_t reserve = (dtaudio > 0) ? size_t(ns_to_audio_frames(m_audio_info.samples_per_sec, (uint64_t)dtaudio)) : 0;
+    const auto window = m_scope_window;
+    const auto total = m_capturebufs[0].size / sizeof(float);
+    if(total < (reserve + window))
+        return;
+    const auto oldest = m_capture_frames - total;
+    const auto limit = m_capture_frames - reserve - window + 1; // end of possible trigger positions
+
+    // search only what arrived since the last tick, one contiguous run of the ring at a time
+    auto scan = std::max(m_scope_scan, oldest);
+    while(scan < limit)
+    {
+        auto count = (size_t)(limit - scan);
+        const auto samples = capture_run(0, (size_t)(scan - oldest), count);
+        const auto trigger = find_trigger(samples, count);
+        if(trigger < count)
+            m_scope_trigger = scan + trigger;
+        scan += count;
+    }
+    m_scope_scan = scan;
+
+    // without a trigger in the buffer show the newest window
+    const auto start = (size_t)(((m_scope_trigger >= oldest) ? m_scope_trigger : (limit - 1)) - oldest);
+    const auto step = (outsz > 1) ? (float)(window - 1) / (float)(outsz - 1) : 0.0f;
+    const auto gain = m_normalize_volume ? std::pow(10.0f, std::min(m_volume_target - dbfs(m_input_rms), m_max_gain) / 20.0f) : 1.0f;
+    const auto mixdown = !m_stereo && (m_capture_channels > 1);
+    auto sample = [&](unsigned int channel, size_t index) {
+        auto& buf = m_capturebufs[std::min(channel, m_capture_channels - 1)];
+        return *(const float*)circlebuf_data(&buf, index * sizeof(float));
+    };
+
+    auto silent = true;
+    for(auto channel = 0u; channel < channels; ++channel)
+    {
+        for(size_t i = 0; i < outsz; ++i)
+        {
+            const auto x = (float)i * step;
+            const auto index = std::min(start + (size_t)x, start + window - 2);
+            const auto t = x - (float)(index - start);
+            auto a = sample(channel, index);
+            auto b = sample(channel, index + 1);
+            if(mixdown)
+            {
+                a = (a + sample(1, index)) * 0.5f;
+                b = (b + sample(1, index + 1)) * 0.5f;
+            }
+            const auto val = lerp(a, b, t) * gain;
+            silent = silent && (val == 0.0f);
+            m_decibels[channel][i] = val;
+        }
+    }
+    m_last_silent = silent;
+}
+
+void WAVSourceGeneric::tick_vectorscope([[maybe_unused]] float seconds)
+{
+    const auto dtcapture = m_tick_ts - m_capture_ts;
+    if(!showing() || (dtcapture > CAPTURE_TIMEOUT))
+    {
+        m_vector_count = 0;
+        m_vector_head = 0;
+        m_correlation = 0.0f;
+        m_last_silent = true;
+        return;
+    }
+
+    // audio held back for sync isn't shown yet
+    const int64_t dtaudio = get_audio_sync(m_tick_ts);
+    const size_t reserve = (dtaudio > 0) ? size_t(ns_to_audio_frames(m_audio_info.samples_per_sec, (uint64_t)dtaudio)) : 0;
+    const auto window = m_vector_window;
+    const auto total = m_capturebufs[0].size / sizeof(float);
+    if(total <= reserve)
+        return;
+    const auto oldest = m_capture_frames - total;
+    const auto end = m_capture_frames - reserve;
+    const auto right = (m_capture_channels > 1) ? 1u : 0u;
+
+    // more than a window behind (or ahead after a sync change), start over with the newest window
+    if((m_vector_pos < oldest) || (m_vector_pos > end) || ((end - m_vector_pos) > window))
+    {
+        m_vector_pos = std::max(end - std::min((uint64_t)window, end - oldest), oldest);
+        m_corr_start = m_vector_pos;
+        m_corr_lr = m_corr_ll = m_corr_rr = 0.0;
+        m_vector_head = 0;
+        m_vector_count = 0;
+    }
+
+    // correlation: add the new samples, drop the ones leaving the window
+    for(auto pos = m_vector_pos; pos < end;)
+    {
+        auto count = (size_t)(end - pos);
+        const auto index = (size_t)(pos - oldest);
+        const auto l = capture_run(0, index, count);
+        const auto r = capture_run(right, index, count);
+        const auto leaving = (pos >= (m_corr_start + window)) && ((pos - window) >= oldest);
+        if(leaving)
+        {
+            const auto old_index = index - window;
+            const auto old_l = capture_run(0, old_index, count);
+            const auto old_r = capture_run(right, old_index, count);
+            for(size_t i = 0; i < count; ++i)
+            {
+                m_corr_lr -= (double)old_l[i] * old_r[i];
+                m_corr_ll -= (double)old_l[i] * old_l[i];
+                m_corr_rr -= (double)old_r[i] * old_r[i];
+            }
+        }
+        else
+            count = std::min(count, (size_t)std::max((int64_t)(m_corr_start + window - pos), (int64_t)1)); // stop where samples start leaving
+        for(size_t i = 0; i < count; ++i)
+        {
+            m_corr_lr += (double)l[i] * r[i];
+            m_corr_ll += (double)l[i] * l[i];
+            m_corr_rr += (double)r[i] * r[i];
+        }
+        pos += count;
+    }
+    m_corr_ll = std::max(m_corr_ll, 0.0);
+    m_corr_rr = std::max(m_corr_rr, 0.0);
+    const auto energy = m_corr_ll * m_corr_rr;
+    m_last_silent = (m_corr_ll + m_corr_rr) < ((double)window * 1e-10); // below -100 dBFS
+    m_correlation = (m_last_silent || (energy <= 0.0)) ? 0.0f : (float)std::clamp(m_corr_lr / std::sqrt(energy), -1.0, 1.0);
+
+    // points for every m_vector_stride-th sample, straight into the vertex data
+    if(m_vector_points != nullptr)
+    {
+        const auto stride = m_vector_stride;
+        auto pos = ((m_vector_pos + stride - 1) / stride) * stride;
+        float lbuf[64], rbuf[64];
+        while(pos < end)
+        {
+            const float *l, *r;
+            size_t count;
+            if(stride == 1)
+            {
+                count = std::min((size_t)(end - pos), m_vector_capacity - m_vector_head);
+                const auto index = (size_t)(pos - oldest);
+                l = capture_run(0, index, count);
+                r = capture_run(right, index, count);
+                pos += count;
+            }
+            else
+            {
+                const auto max_count = std::min((size_t)64, m_vector_capacity - m_vector_head);
+                for(count = 0; (count < max_count) && (pos < end); ++count, pos += stride)
+                {
+                    const auto index = (size_t)(pos - oldest);
+                    lbuf[count] = *(const float*)circlebuf_data(&m_capturebufs[0], index * sizeof(float));
+                    rbuf[count] = *(const float*)circlebuf_data(&m_capturebufs[right], index * sizeof(float));
+                }
+                l = lbuf;
+                r = rbuf;
+            }
+            vector_points(l, r, count, &m_vector_points[m_vector_head]);
+            m_vector_head = (m_vector_head + count) % m_vector_capacity;
+            m_vector_count = std::min(m_vector_count + count, m_vector_capacity);
+        }
+    }
+    m_vector_pos = end;
+}
+
+void WAVSourceGeneric::tick_filterbank([[maybe_unused]] float seconds)
+{
+    const auto outsz = m_bin_count;
+    const auto dtcapture = m_tick_ts - m_capture_ts;
+
+    if(!showing() || (dtcapture > CAPTURE_TIMEOUT))
+    {
+        if(m_last_silent)
+            return;
+        m_filterbank.reset();
+        for(auto channel = 0u; channel < m_capture_channels; ++channel)
+            if(m_tsmooth_buf[channel] != nullptr)
+                memset(m_tsmooth_buf[channel].get(), 0, outsz * sizeof(float));
+        for(auto channel = 0; channel < (m_stereo ? 2 : 1); ++channel)
+            for(size_t i = 0; i < outsz; ++i)
+                m_decibels[channel][i] = DB_MIN;
+        m_last_silent = true;
+        return;
+    }
+
+    // every sample goes through the bank once, audio held back for sync waits for a later tick
+    const int64_t dtaudio = get_audio_sync(m_tick_ts);
+    const size_t reserve = (dtaudio > 0) ? size_t(ns_to_audio_frames(m_capture_rate, (uint64_t)dtaudio)) : 0;
+    const auto total = m_capturebufs[0].size / sizeof(float);
+    if(total <= reserve)
+        return;
+    const auto oldest = m_capture_frames - total;
+    const auto end = m_capture_frames - reserve;
+    const auto start = std::max(m_filterbank_pos, oldest);
+    if(start >= end)
+        return;
+    m_filterbank_pos = end;
+
+    const auto g = get_gravity(seconds);
+    const auto g2 = 1.0f - g;
+    const bool slope = m_slope > 0.0f;
+    auto silent_channels = 0u;
+    for(auto channel = 0u; channel < m_capture_channels; ++channel)
+    {
+        auto silent = true;
+        for(auto pos = start; silent && (pos < end);)
+        {
+            auto count = (size_t)(end - pos);
+            const auto samples = capture_run(channel, (size_t)(pos - oldest), count);
+            silent = std::all_of(samples, samples + count, [](float x) { return x == 0.0f; });
+            pos += count;
+        }
+
+        if(silent)
+        {
+            // start over instead of letting the filter state decay into denormals
+            m_filterbank.reset(channel);
+            if(m_last_silent)
+                continue;
+            bool outsilent = true;
+            auto floor = (float)(m_floor - 10);
+            const auto ch = (m_stereo) ? channel : 0u;
+            for(size_t i = 0; i < outsz; ++i)
+            {
+                if(m_decibels[ch][i] > floor)
+                {
+                    outsilent = false;
+                    break;
+                }
+            }
+            if(outsilent)
+            {
+                if(++silent_channels >= m_capture_channels)
+                    m_last_silent = true;
+                continue;
+            }
+        }
+        else
+        {
+            m_last_silent = false;
+            for(auto pos = start; pos < end;)
+            {
+                auto count = (size_t)(end - pos);
+                const auto samples = capture_run(channel, (size_t)(pos - oldest), count);
+                m_filterbank.process(channel, samples, count);
+                pos += count;
+            }
+        }
+
+        m_filterbank.levels(channel, m_decibels[channel].get());
+        for(size_t i = 0; i < outsz; ++i)
+        {
+            auto mag = m_decibels[channel][i];
+            if(slope)
+                mag *= m_slope_modifiers[i];
+
+            if(m_tsmoothing != TSmoothingMode::NONE)
+            {
+                auto oldval = m_tsmooth_buf[channel][i];
+                if(m_fast_peaks)
+                    oldval = std::max(mag, oldval);
+                mag = (g * oldval) + (g2 * mag);
+                m_tsmooth_buf[channel][i] = mag;
+            }
+
+            m_decibels[channel][i] = mag;
+        }
+    }
+
+    if(m_last_silent)
+        return;
+
+    if(m_output_channels > m_capture_channels)
+        memcpy(m_decibels[1].get(), m_decibels[0].get(), outsz * sizeof(float));
+
+    if(m_stereo)
+    {
+        for(auto channel = 0; channel < 2; ++channel)
+            for(size_t i = 0; i < outsz; ++i)
+                m_decibels[channel][i] = dbfs(m_decibels[channel][i]);
+    }
+    else if(m_capture_channels > 1)
+    {
+        for(size_t i = 0; i < outsz; ++i)
+            m_decibels[0][i] = dbfs((m_decibels[0][i] + m_decibels[1][i]) * 0.5f);
+    }
+    else
+    {
+        for(size_t i = 0; i < outsz; ++i)
+            m_decibels[0][i] = dbfs(m_decibels[0][i]);
+    }
+
+    if(m_normalize_volume)
+    {
+        const auto volume_compensation = std::min(m_volume_target - dbfs(m_input_rms), m_max_gain);
+        for(auto channel = 0; channel < (m_stereo ? 2 : 1); ++channel)
+            for(size_t i = 0; i < outsz; ++i)
+                m_decibels[channel][i] += volume_compensation;
+    }
+
+    if((m_rolloff_q > 0.0f) && (m_rolloff_rate > 0.0f))
+    {
+        for(auto channel = 0; channel < (m_stereo ? 2 : 1); ++channel)
+            for(size_t i = 0; i < outsz; ++i)
+                m_decibels[channel][i] = std::max(m_decibels[channel][i] - m_rolloff_modifiers[i], DB_MIN);
+    }
+}
+
+void WAVSourceGeneric::vector_points(const float *left, const float *right, size_t count, vec3 *out)
+{
+    // side across, mid up
+    for(size_t i = 0; i < count; ++i)
+        vec3_set(&out[i], m_vector_cx + ((left[i] - right[i]) * m_vector_scale), m_vector_cy - ((left[i] + right[i]) * m_vector_scale), 0.0f);
+}
+
+size_t WAVSourceGeneric::find_trigger(const float *samples, size_t count)
+{
+    // rising through the level after having been below it by the hysteresis, the last one wins
+    const auto low = m_trigger_level - m_trigger_hysteresis;
+    const auto high = m_trigger_level;
+    auto armed = m_trigger_armed;
+    auto found = count;
+    for(size_t i = 0; i < count; ++i)
+    {
+        if(!armed)
+            armed = samples[i] < low;
+        else if(samples[i] >= high)
+        {
+            armed = false;
+            found = i;
+        }
+    }
+    m_trigger_armed = armed;
+    return found;
+}
+
 void WAVSourceGeneric::update_input_rms()
 {
     assert(m_normalize_volume);
@@ -401,3 +788,30 @@ void WAVSourceGeneric::update_input_rms()
         sum += m_input_rms_buf[i];
     m_input_rms = std::sqrt(sum / m_input_rms_size);
 }
+
+void WAVSourceGeneric::accumulate_ltas(size_t count)
+{
+    // power of the magnitudes about to be converted for display, channels mixed the same way
+    // scaled by the volume normalization that follows, which leaves the DC bin alone
+    const auto gain = normalize_power_gain();
+    const size_t dc = (m_bin_start > 0) ? 0 : 1;
+    if(m_stereo || (m_capture_channels < 2))
+    {
+        for(auto channel = 0; channel < (m_stereo ? 2 : 1); ++channel)
+        {
+            auto sums = m_ltas.partial(channel);
+            for(size_t i = 0; i < count; ++i)
+                sums[i] += m_decibels[channel][i] * m_decibels[channel][i] * ((i < dc) ? 1.0f : gain);
+        }
+    }
+    else
+    {
+        auto sums = m_ltas.partial(0);
+        for(size_t i = 0; i < count; ++i)
+        {
+            auto mag = (m_decibels[0][i] + m_decibels[1][i]) * 0.5f;
+            sums[i] += mag * mag * ((i < dc) ? 1.0f : gain);
+        }
+    }
+    m_ltas.commit();
+}
@@ -0,0 +1,330 @@
+/*
+    Copyright (C) 2024 Devin Davila
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "spectrum_history.hpp"
+#include "log.hpp"
+#include <util/bmem.h>
+#include <util/platform.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <string>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static constexpr char HISTORY_MAGIC[8] = { 'W', 'A', 'V', 'S', 'P', 'H', 'S', 'T' };
+static constexpr uint32_t HISTORY_VERSION = 1;
+static constexpr int MAX_BACKUPS = 16;
+
+// an existing file that can't be appended to is renamed to path.N.bak rather than overwritten
+// returns false if it had to stay where it is
+static bool move_aside(const char *path, const SpectrumHistoryHeader& header, uint64_t size)
+{
+    auto file = os_fopen(path, "rb");
+    if(file == nullptr)
+        return true;
+    SpectrumHistoryHeader existing{};
+    const auto cur = os_fgetsize(file);
+    const auto read = fread(&existing, 1, sizeof(existing), file);
+    fclose(file);
+    if((cur == 0) || (((uint64_t)cur == size) && (read == sizeof(existing)) && (memcmp(&existing, &header, sizeof(header)) == 0)))
+        return true;
+
+    for(auto i = 1; i <= MAX_BACKUPS; ++i)
+    {
+        const auto backup = std::string(path) + "." + std::to_string(i) + ".bak";
+        if(os_file_exists(backup.c_str()))
+            continue;
+        if(os_rename(path, backup.c_str()) != 0)
+            break;
+        LogInfo << "Spectrum history \"" << path << "\" was written in another format or length, moved it to \"" << backup << "\"";
+        return true;
+    }
+    LogWarn << "Spectrum history \"" << path << "\" was written in another format or length and could not be moved aside, not overwriting it";
+    return false;
+}
+
+// read/write file mapping of a fixed size, 'existing' is set if the file already had that size
+struct SpectrumHistory::Mapping
+{
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#else
+    int fd = -1;
+#endif
+    void *view = nullptr;
+    size_t size = 0;
+
+    bool open(const char *path, size_t sz, bool& existing);
+    ~Mapping();
+};
+
+#ifdef _WIN32
+bool SpectrumHistory::Mapping::open(const char *path, size_t sz, bool& existing)
+{
+    wchar_t *wpath = nullptr;
+    if(os_utf8_to_wcs_ptr(path, 0, &wpath) == 0)
+        return false;
+    file = CreateFileW(wpath, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    bfree(wpath);
+    if(file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER cur{};
+    existing = GetFileSizeEx(file, &cur) && ((uint64_t)cur.QuadPart == sz);
+    if(!existing)
+    {
+        // truncate first so the whole file reads back as zeros
+        LARGE_INTEGER pos{};
+        if(!SetFilePointerEx(file, pos, nullptr, FILE_BEGIN) || !SetEndOfFile(file))
+            return false;
+        pos.QuadPart = (LONGLONG)sz;
+        if(!SetFilePointerEx(file, pos, nullptr, FILE_BEGIN) || !SetEndOfFile(file))
+            return false;
+    }
+
+    mapping = CreateFileMappingW(file, nullptr, PAGE_READWRITE, (DWORD)((uint64_t)sz >> 32), (DWORD)(sz & 0xffffffffu), nullptr);
+    if(mapping == nullptr)
+        return false;
+    view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, sz);
+    size = sz;
+    return view != nullptr;
+}
+
+SpectrumHistory::Mapping::~Mapping()
+{
+    if(view != nullptr)
+        UnmapViewOfFile(view);
+    if(mapping != nullptr)
+        CloseHandle(mapping);
+    if(file != INVALID_HANDLE_VALUE)
+        CloseHandle(file);
+}
+#else
+bool SpectrumHistory::Mapping::open(const char *path, size_t sz, bool& existing)
+{
+    fd = ::open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if(fd < 0)
+        return false;
+
+    struct stat st{};
+    existing = (fstat(fd, &st) == 0) && ((uint64_t)st.st_size == sz);
+    if(!existing)
+    {
+        // truncate first so the whole file reads back as zeros
+        if(ftruncate(fd, 0) != 0)
+            return false;
+#ifdef __APPLE__
+        if(ftruncate(fd, (off_t)sz) != 0)
+            return false;
+#elif defined(__linux__)
+        // reserve the blocks now, running out of space later would fault on a write to the mapping
+        // fallocate() rather than posix_fallocate(), glibc emulates the latter by writing every block
+        // filesystems that can't preallocate get a sparse file as before
+        if((fallocate(fd, 0, 0, (off_t)sz) != 0) && (((errno != EOPNOTSUPP) && (errno != ENOSYS)) || (ftruncate(fd, (off_t)sz) != 0)))
+            return false;
+#else
+        const auto err = posix_fallocate(fd, 0, (off_t)sz);
+        if((err != 0) && (((err != EINVAL) && (err != EOPNOTSUPP)) || (ftruncate(fd, (off_t)sz) != 0)))
+            return false;
+#endif
+    }
+
+    // not populated, this runs on the graphics thread and append() only touches a few pages per chunk
+    auto ptr = mmap(nullptr, sz, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(ptr == MAP_FAILED)
+        return false;
+    view = ptr;
+    size = sz;
+    return true;
+}
+
+SpectrumHistory::Mapping::~Mapping()
+{
+    if(view != nullptr)
+        munmap(view, size);
+    if(fd >= 0)
+        ::close(fd);
+}
+#endif // _WIN32
+
+bool SpectrumHistory::open(const SpectrumHistoryFormat& format, uint64_t frames, const char *path)
+{
+    // update() runs on the graphics thread for any settings change, remapping (or clearing) up to MAX_BYTES each time would stall it
+    const std::string new_path = (path != nullptr) ? path : "";
+    if((m_base != nullptr) && (format == m_format) && (frames == m_frames) && (new_path == m_path))
+        return true;
+    close();
+    if((format.channels == 0) || (format.bins == 0) || (frames == 0))
+        return false;
+
+    SpectrumHistoryHeader header{};
+    memcpy(header.magic, HISTORY_MAGIC, sizeof(header.magic));
+    header.version = HISTORY_VERSION;
+    header.header_size = sizeof(SpectrumHistoryHeader);
+    header.channels = format.channels;
+    header.bins = format.bins;
+    header.bin_start = format.bin_start;
+    header.fft_size = format.fft_size;
+    header.sample_rate = format.sample_rate;
+    header.sample_bytes = (format.sample_bytes > 1) ? 2 : 1;
+    header.db_offset = (header.sample_bytes > 1) ? -160.0f : -120.0f;
+    header.db_step = (header.sample_bytes > 1) ? (1.0f / 256.0f) : 0.5f;
+    header.chunk_frames = CHUNK_FRAMES;
+
+    // a partially written chunk is kept on top of the requested length
+    const auto frame_bytes = (uint64_t)header.channels * header.bins * header.sample_bytes;
+    header.chunk_bytes = (sizeof(SpectrumChunkHeader) + (CHUNK_FRAMES * (sizeof(uint64_t) + frame_bytes)) + 63) & ~(uint64_t)63;
+    auto chunks = ((frames + CHUNK_FRAMES - 1) / CHUNK_FRAMES) + 1;
+    const auto max_chunks = std::max((MAX_BYTES - header.header_size) / header.chunk_bytes, (uint64_t)2);
+    if(chunks > max_chunks)
+    {
+        LogWarn << "Spectrum history limited to " << ((max_chunks - 1) * CHUNK_FRAMES) << " of " << frames << " frames";
+        chunks = max_chunks;
+    }
+    header.num_chunks = (uint32_t)chunks;
+    const auto total = (size_t)(header.header_size + (chunks * header.chunk_bytes));
+
+    auto existing = false;
+    if((path != nullptr) && (*path != '\0'))
+    {
+        if(!move_aside(path, header, total))
+            return false;
+        m_mapping = std::make_unique<Mapping>();
+        if(!m_mapping->open(path, total, existing))
+        {
+            LogWarn << "Failed to map spectrum history file: \"" << path << "\"";
+            m_mapping.reset();
+            return false;
+        }
+        m_base = static_cast<uint8_t*>(m_mapping->view);
+    }
+    else
+    {
+        // frame data is written before it's read, only the chunk headers need clearing
+        m_memory.reset(new(std::nothrow) uint8_t[total]);
+        if(m_memory == nullptr)
+        {
+            LogWarn << "Failed to allocate " << total << " bytes for the spectrum history";
+            return false;
+        }
+        m_base = m_memory.get();
+    }
+
+    m_header = header;
+    m_format = format;
+    m_frames = frames;
+    m_path = new_path;
+    m_frame_bytes = (size_t)frame_bytes;
+    m_clock_offset = (int64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count() - (int64_t)os_gettime_ns();
+
+    // carry on after the newest chunk of a file written in the same format
+    if(existing && (memcmp(m_base, &header, sizeof(header)) == 0))
+    {
+        m_chunk = 0;
+        m_seq = 0;
+        for(uint32_t i = 0; i < header.num_chunks; ++i)
+        {
+            auto seq = chunk_header(i)->seq;
+            if(seq > m_seq)
+            {
+                m_seq = seq;
+                m_chunk = i;
+            }
+        }
+        if(m_seq > 0)
+        {
+            chunk_header(m_chunk)->frames = std::min(chunk_header(m_chunk)->frames, CHUNK_FRAMES);
+            if(path != nullptr)
+                LogInfo << "Appending to spectrum history \"" << path << "\"";
+            return true;
+        }
+    }
+
+    memcpy(m_base, &header, sizeof(header));
+    for(uint32_t i = 0; i < header.num_chunks; ++i)
+        *chunk_header(i) = {};
+    m_chunk = 0;
+    m_seq = 1;
+    chunk_header(0)->seq = m_seq;
+    return true;
+}
+
+SpectrumHistory::SpectrumHistory() = default;
+
+SpectrumHistory::~SpectrumHistory()
+{
+    close();
+}
+
+void SpectrumHistory::close()
+{
+    m_base = nullptr;
+    m_mapping.reset();
+    m_memory.reset();
+}
+
+template<typename T>
+static void quantize(const float *in, size_t count, float offset, float scale, T *out)
+{
+    constexpr auto maxq = (float)std::numeric_limits<T>::max();
+    for(size_t i = 0; i < count; ++i)
+        out[i] = (T)std::clamp(((in[i] - offset) * scale) + 0.5f, 0.0f, maxq);
+}
+
+void SpectrumHistory::append(uint64_t ts, const float *const *channels)
+{
+    auto hdr = chunk_header(m_chunk);
+    auto n = hdr->frames;
+    if(n >= m_header.chunk_frames)
+    {
+        // start the next chunk, the oldest frames go with it
+        m_chunk = (m_chunk + 1) % m_header.num_chunks;
+        hdr = chunk_header(m_chunk);
+        std::atomic_ref(hdr->frames).store(0, std::memory_order_release);
+        std::atomic_ref(hdr->seq).store(++m_seq, std::memory_order_release);
+        n = 0;
+    }
+
+    auto data = reinterpret_cast<uint8_t*>(hdr) + sizeof(SpectrumChunkHeader);
+    reinterpret_cast<uint64_t*>(data)[n] = (uint64_t)((int64_t)ts + m_clock_offset);
+    auto frame = data + (m_header.chunk_frames * sizeof(uint64_t)) + (n * m_frame_bytes);
+    const auto scale = 1.0f / m_header.db_step;
+    for(uint32_t channel = 0; channel < m_header.channels; ++channel)
+    {
+        if(m_header.sample_bytes > 1)
+            quantize(channels[channel], m_header.bins, m_header.db_offset, scale, reinterpret_cast<uint16_t*>(frame) + (channel * m_header.bins));
+        else
+            quantize(channels[channel], m_header.bins, m_header.db_offset, scale, frame + (channel * m_header.bins));
+    }
+
+    // publish the frame to readers of the mapping
+    std::atomic_ref(hdr->frames).store(n + 1, std::memory_order_release);
+}
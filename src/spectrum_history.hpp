@@ -0,0 +1,118 @@
+/*
+    Copyright (C) 2024 Devin Davila
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Rolling store of the last N minutes of analyzed spectra, in memory or in a memory mapped file.
+// Everything is allocated (or mapped) by open(), append() only writes into the ring.
+//
+// Layout: SpectrumHistoryHeader, followed by 'num_chunks' chunks of 'chunk_bytes' each.
+// A chunk is a SpectrumChunkHeader, 'chunk_frames' uint64_t timestamps (UNIX time in ns) and then
+// 'chunk_frames' frames of 'channels' * 'bins' samples (uint8_t or uint16_t, sample_bytes).
+// Sample q of bin i is FFT bin (bin_start + i) at (bin_start + i) * sample_rate / fft_size Hz, with a level
+// of db_offset + (q * db_step) dBFS, 0 means at or below db_offset.
+// Chunks are written in order of 'seq', starting at 1, chunks with seq 0 have never been written.
+// Only the first 'frames' frames of a chunk are valid, the count is updated after the frame is written.
+// All values are native endian.
+
+struct SpectrumHistoryHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t channels;
+    uint32_t bins;
+    uint32_t bin_start;
+    uint32_t fft_size;
+    uint32_t sample_rate;
+    uint32_t sample_bytes;
+    float db_offset;
+    float db_step;
+    uint32_t chunk_frames;
+    uint32_t num_chunks;
+    uint64_t chunk_bytes;
+};
+
+struct SpectrumChunkHeader
+{
+    uint64_t seq;
+    uint32_t frames;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(SpectrumHistoryHeader) == 64, "SpectrumHistoryHeader must be tightly packed");
+static_assert(sizeof(SpectrumChunkHeader) == 16, "SpectrumChunkHeader must be tightly packed");
+
+struct SpectrumHistoryFormat
+{
+    uint32_t channels = 0;
+    uint32_t bins = 0;
+    uint32_t bin_start = 0;
+    uint32_t fft_size = 0;
+    uint32_t sample_rate = 0;
+    uint32_t sample_bytes = 1;      // 1 (0.5 dB steps) or 2 (1/256 dB steps)
+
+    bool operator==(const SpectrumHistoryFormat&) const = default;
+};
+
+class SpectrumHistory
+{
+public:
+    static constexpr uint32_t CHUNK_FRAMES = 256;
+    static constexpr uint64_t MAX_BYTES = 1ull << 31;  // frames beyond this are not retained
+
+    SpectrumHistory();
+    ~SpectrumHistory();
+
+    SpectrumHistory(const SpectrumHistory&) = delete;
+    SpectrumHistory& operator=(const SpectrumHistory&) = delete;
+
+    // keep at least 'frames' frames, 'path' may be null or empty for a memory only store
+    // an existing file of the same format and length is appended to, anything else is renamed to path.N.bak first
+    // a store already open with the same arguments is kept as it is
+    bool open(const SpectrumHistoryFormat& format, uint64_t frames, const char *path);
+    void close();
+
+    explicit operator bool() const noexcept { return m_base != nullptr; }
+
+    // one frame of 'bins' dBFS values per channel, 'ts' in os_gettime_ns() time
+    void append(uint64_t ts, const float *const *channels);
+
+private:
+    struct Mapping;
+
+    uint8_t *m_base = nullptr;
+    std::unique_ptr<uint8_t[]> m_memory;
+    std::unique_ptr<Mapping> m_mapping;
+    SpectrumHistoryHeader m_header{};
+    SpectrumHistoryFormat m_format;  // arguments of the last open()
+    uint64_t m_frames = 0;
+    std::string m_path;
+    size_t m_frame_bytes = 0;
+    uint32_t m_chunk = 0;           // chunk being written
+    uint64_t m_seq = 0;             // its sequence number
+    int64_t m_clock_offset = 0;     // os_gettime_ns() to UNIX time
+
+    SpectrumChunkHeader *chunk_header(uint32_t chunk) const
+    {
+        return reinterpret_cast<SpectrumChunkHeader*>(m_base + m_header.header_size + (chunk * m_header.chunk_bytes));
+    }
+};
@@ -0,0 +1,33 @@
+/*
+    Copyright (C) 2024 Devin Davila
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include "waveform_config.hpp"
+
+// USDT probes for perf/bpftrace, provider name is "waveform"
+// e.g. bpftrace -e 'usdt:/path/to/waveform.so:waveform:tick_end { ... }'
+// disabled probes compile to a single nop
+#ifdef ENABLE_USDT
+#include <sys/sdt.h>
+#define WAV_TRACE1(name, a) DTRACE_PROBE1(waveform, name, a)
+#define WAV_TRACE2(name, a, b) DTRACE_PROBE2(waveform, name, a, b)
+#define WAV_TRACE4(name, a, b, c, d) DTRACE_PROBE4(waveform, name, a, b, c, d)
+#else
+#define WAV_TRACE1(name, a) ((void)0)
+#define WAV_TRACE2(name, a, b) ((void)0)
+#define WAV_TRACE4(name, a, b, c, d) ((void)0)
+#endif
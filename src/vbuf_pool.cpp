@@ -0,0 +1,123 @@
+/*
+    Copyright (C) 2024 Devin Davila
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "vbuf_pool.hpp"
+#include "log.hpp"
+#include <algorithm>
+#include <bit>
+#include <unordered_map>
+#include <vector>
+
+namespace vbuf_pool
+{
+    namespace
+    {
+        constexpr size_t MIN_CAPACITY = 256;
+        constexpr size_t MAX_IDLE_VERTS = 1 << 20; // idle buffers beyond this are destroyed, oldest first
+
+        std::unordered_map<gs_vertbuffer_t*, size_t> capacities; // every buffer owned by the pool
+        std::vector<gs_vertbuffer_t*> idle;                       // oldest first
+        size_t idle_verts = 0;
+
+        gs_vertbuffer_t *create(size_t capacity)
+        {
+            auto vbdata = gs_vbdata_create();
+            vbdata->num = capacity;
+            vbdata->points = (vec3*)bzalloc(capacity * sizeof(vec3));
+            vbdata->num_tex = 1;
+            vbdata->tvarray = (gs_tvertarray*)bzalloc(sizeof(gs_tvertarray));
+            vbdata->tvarray->width = 2;
+            vbdata->tvarray->array = bzalloc(2 * capacity * sizeof(float));
+            return gs_vertexbuffer_create(vbdata, GS_DYNAMIC);
+        }
+
+        void destroy(gs_vertbuffer_t *vbuf)
+        {
+            capacities.erase(vbuf);
+            gs_vertexbuffer_destroy(vbuf);
+        }
+    }
+
+    gs_vertbuffer_t *acquire(size_t num_verts)
+    {
+        if(num_verts == 0)
+            return nullptr;
+        const auto capacity = std::bit_ceil(std::max(num_verts, MIN_CAPACITY));
+
+        // smallest idle buffer that fits, newest first among equals
+        gs_vertbuffer_t *vbuf = nullptr;
+        auto best = idle.rend();
+        for(auto it = idle.rbegin(); it != idle.rend(); ++it)
+        {
+            const auto size = capacities[*it];
+            if((size >= capacity) && ((best == idle.rend()) || (size < capacities[*best])))
+                best = it;
+        }
+        if(best != idle.rend())
+        {
+            vbuf = *best;
+            idle.erase(std::next(best).base());
+            idle_verts -= capacities[vbuf];
+        }
+        else
+        {
+            vbuf = create(capacity);
+            if(vbuf == nullptr)
+            {
+                LogError << "Failed to create vertex buffer of " << capacity << " vertices";
+                return nullptr;
+            }
+            capacities[vbuf] = capacity;
+        }
+
+        gs_vertexbuffer_get_data(vbuf)->num = num_verts;
+        return vbuf;
+    }
+
+    void release(gs_vertbuffer_t *vbuf)
+    {
+        if(vbuf == nullptr)
+            return;
+        auto it = capacities.find(vbuf);
+        if(it == capacities.end())
+        {
+            gs_vertexbuffer_destroy(vbuf);
+            return;
+        }
+
+        const auto capacity = it->second;
+        gs_vertexbuffer_get_data(vbuf)->num = capacity;
+        idle.push_back(vbuf);
+        idle_verts += capacity;
+
+        // keep the newest buffers, they're the likeliest to be asked for again
+        while((idle_verts > MAX_IDLE_VERTS) && (idle.size() > 1))
+        {
+            idle_verts -= capacities[idle.front()];
+            destroy(idle.front());
+            idle.erase(idle.begin());
+        }
+    }
+
+    void clear()
+    {
+        for(auto i : idle)
+            destroy(i);
+        idle.clear();
+        idle_verts = 0;
+    }
+}
@@ -0,0 +1,32 @@
+/*
+    Copyright (C) 2024 Devin Davila
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <obs-module.h>
+#include <cstddef>
+
+// Dynamic vertex buffers (points + one 2-wide texcoord array) shared by all sources.
+// Capacities are rounded up to a power of two and buffers are handed back out whenever the
+// requested count fits, so updates that don't change the size don't touch the GPU allocator.
+// The vertex count (gs_vb_data::num) is set to the requested count, flushes and draws only cover that.
+// Graphics thread only (between obs_enter_graphics() and obs_leave_graphics()).
+namespace vbuf_pool
+{
+    gs_vertbuffer_t *acquire(size_t num_verts);
+    void release(gs_vertbuffer_t *vbuf);    // null is ignored
+    void clear();                           // destroy idle buffers
+}